@@ -0,0 +1,309 @@
+/**
+ * @file   allocator.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Bump arena and fixed-size pool implementations of the 'mc_allocator' interface (see allocator.h).
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "allocator.h"
+
+
+// The alignment of every block returned by the system allocator (and therefore of every pool block)
+#define MC_MAX_ALIGN 16
+
+#define align_up(x, a) (((x) + ((a) - 1)) & ~((uintptr_t)(a) - 1))
+
+
+
+typedef struct mc_arena_block_s {
+    struct mc_arena_block_s *next;          // The previous (older) block
+    size_t size;                            // The number of usable bytes on this block
+    size_t used;                            // The number of bytes already served from this block
+    unsigned char *last;                    // The most recent allocation served from this block
+    unsigned char  data[];                  // The memory served by the arena
+} mc_arena_block;
+
+struct mc_arena_s {
+    mc_arena_block *head;                   // The current block
+    size_t blockSize;                       // The minimal size of a new block
+};
+
+
+static mc_arena_block *arena_new_block(mc_arena arena, size_t minSize) {
+    const size_t size = (minSize > arena->blockSize) ? minSize : arena->blockSize;
+
+    if (size > SIZE_MAX - sizeof (mc_arena_block))
+        return NULL;
+
+    mc_arena_block *block = (mc_arena_block*)(malloc(sizeof (mc_arena_block) + size));
+
+    if (!block)
+        return NULL;
+
+    block->next = arena->head;
+    block->size = size;
+    block->used = 0;
+    block->last = NULL;
+
+    arena->head = block;
+    return block;
+}
+
+static void *arena_alloc(void *ctx, size_t size, size_t align) {
+    mc_arena arena = (mc_arena)(ctx);
+    mc_arena_block *block = arena->head;
+
+    if (align == 0)
+        align = 1;
+
+    if (block) {
+        const uintptr_t base = (uintptr_t)(block->data);
+        const uintptr_t start = align_up(base + block->used, align);
+
+        if (start + size <= base + block->size) {
+            block->used = (size_t)(start - base) + size;
+            block->last = (unsigned char*)(start);
+            return block->last;
+        }
+    }
+
+    if (size > SIZE_MAX - align || !(block = arena_new_block(arena, size + align)))
+        return NULL;
+
+    const uintptr_t base = (uintptr_t)(block->data);
+    const uintptr_t start = align_up(base, align);
+
+    block->used = (size_t)(start - base) + size;
+    block->last = (unsigned char*)(start);
+    return block->last;
+}
+
+static void *arena_realloc(void *ctx, void *ptr, size_t oldSize, size_t newSize, size_t align) {
+    mc_arena arena = (mc_arena)(ctx);
+    mc_arena_block *block = arena->head;
+
+    if (!ptr)
+        return arena_alloc(ctx, newSize, align);
+
+    if (block && block->last == ptr && (size_t)(block->last - block->data) + newSize <= block->size) {
+        // last allocation of the current block, just move the cursor
+        block->used = (size_t)(block->last - block->data) + newSize;
+        return ptr;
+    }
+
+    void *res = arena_alloc(ctx, newSize, align);
+
+    if (!res)
+        return NULL;
+
+    memcpy(res, ptr, (oldSize < newSize) ? oldSize : newSize);
+    return res;
+}
+
+static void arena_free(void *ctx, void *ptr, size_t size) {
+    mc_arena arena = (mc_arena)(ctx);
+    mc_arena_block *block = arena->head;
+
+    (void)size;
+
+    if (block && ptr && block->last == ptr) {
+        block->used = (size_t)(block->last - block->data);
+        block->last = NULL;
+    }
+}
+
+
+mc_arena mc_arena_make(size_t blockSize) {
+    if (blockSize == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    mc_arena res = (mc_arena)(malloc(sizeof (struct mc_arena_s)));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    res->head = NULL;
+    res->blockSize = blockSize;
+
+    if (!arena_new_block(res, blockSize)) {
+        free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    return res;
+}
+
+void mc_arena_reset(mc_arena arena) {
+    if (!arena || !arena->head)
+        return;
+
+    mc_arena_block *block = arena->head->next;
+
+    while (block) {
+        mc_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head->next = NULL;
+    arena->head->used = 0;
+    arena->head->last = NULL;
+}
+
+void mc_arena_free(mc_arena arena) {
+    if (!arena)
+        return;
+
+    mc_arena_block *block = arena->head;
+
+    while (block) {
+        mc_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+mc_allocator mc_arena_allocator(mc_arena arena) {
+    mc_allocator res = { arena_alloc, arena_realloc, arena_free, arena };
+    return res;
+}
+
+
+
+
+typedef struct mc_pool_chunk_s {
+    struct mc_pool_chunk_s *next;           // The previous (older) chunk
+} mc_pool_chunk;
+
+struct mc_pool_s {
+    void  *freeList;                        // The first free block, each free block stores a pointer to the next one
+    mc_pool_chunk *chunks;                  // Every chunk requested from the system
+    size_t blockSize;                       // The size of a block, rounded up to MC_MAX_ALIGN
+    size_t blocksPerChunk;                  // The number of blocks on a chunk
+};
+
+
+static short pool_grow(mc_pool pool) {
+    const size_t header = align_up(sizeof (mc_pool_chunk), MC_MAX_ALIGN);
+
+    if (pool->blocksPerChunk > (SIZE_MAX - header) / pool->blockSize)
+        return 0;
+
+    mc_pool_chunk *chunk = (mc_pool_chunk*)(malloc(header + pool->blockSize * pool->blocksPerChunk));
+
+    if (!chunk)
+        return 0;
+
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    // thread every block of the chunk on the free list, in address order
+    unsigned char *block = (unsigned char*)(chunk) + header;
+
+    for (size_t i = 0; i < pool->blocksPerChunk; i++, block += pool->blockSize) {
+        *(void**)(block) = (i + 1 < pool->blocksPerChunk) ? (block + pool->blockSize) : pool->freeList;
+    }
+
+    pool->freeList = (unsigned char*)(chunk) + header;
+    return 1;
+}
+
+static void *pool_alloc(void *ctx, size_t size, size_t align) {
+    mc_pool pool = (mc_pool)(ctx);
+
+    if (size > pool->blockSize || align > MC_MAX_ALIGN)
+        return NULL;
+
+    if (!pool->freeList && !pool_grow(pool))
+        return NULL;
+
+    void *res = pool->freeList;
+    pool->freeList = *(void**)(res);
+    return res;
+}
+
+static void *pool_realloc(void *ctx, void *ptr, size_t oldSize, size_t newSize, size_t align) {
+    mc_pool pool = (mc_pool)(ctx);
+
+    (void)oldSize;
+
+    if (!ptr)
+        return pool_alloc(ctx, newSize, align);
+
+    // every block has the same size: either it still fits, or it can't be done
+    return (newSize <= pool->blockSize && align <= MC_MAX_ALIGN) ? ptr : NULL;
+}
+
+static void pool_free(void *ctx, void *ptr, size_t size) {
+    mc_pool pool = (mc_pool)(ctx);
+
+    (void)size;
+
+    if (!ptr)
+        return;
+
+    *(void**)(ptr) = pool->freeList;
+    pool->freeList = ptr;
+}
+
+
+mc_pool mc_pool_make(size_t blockSize, size_t blocksPerChunk) {
+    if (blockSize == 0 || blocksPerChunk == 0 || blockSize > SIZE_MAX - MC_MAX_ALIGN) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    mc_pool res = (mc_pool)(malloc(sizeof (struct mc_pool_s)));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    res->freeList = NULL;
+    res->chunks = NULL;
+    res->blockSize = align_up(blockSize, MC_MAX_ALIGN);
+    res->blocksPerChunk = blocksPerChunk;
+
+    return res;
+}
+
+void mc_pool_free(mc_pool pool) {
+    if (!pool)
+        return;
+
+    mc_pool_chunk *chunk = pool->chunks;
+
+    while (chunk) {
+        mc_pool_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(pool);
+}
+
+mc_allocator mc_pool_allocator(mc_pool pool) {
+    mc_allocator res = { pool_alloc, pool_realloc, pool_free, pool };
+    return res;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file   allocator.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  A minimal allocator interface, used by the vector library to route its allocations somewhere else than the
+ *         global heap. An allocator is a small vtable ('mc_allocator') made of three functions and an opaque context.
+ *         Every function takes the size of the block it works on, so that allocators which don't store any metadata
+ *         (such as arenas and pools) can be implemented.
+ *
+ *         Two implementations are provided:
+ *              - a bump arena ('mc_arena'), which serves allocations from large blocks and releases all of them at once
+ *                with 'mc_arena_reset' or 'mc_arena_free',
+ *              - a fixed-size pool ('mc_pool'), which serves blocks of a single size from a free list.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_ALLOCATOR_H
+#define MC_ALLOCATOR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct mc_allocator {
+    void *(*alloc)(void *ctx, size_t size, size_t align);                                   // Allocates a new block
+    void *(*realloc)(void *ctx, void *ptr, size_t oldSize, size_t newSize, size_t align);   // Resizes a block (ptr may be NULL)
+    void  (*free)(void *ctx, void *ptr, size_t size);                                       // Releases a block
+    void  *ctx;                                                                             // Passed to every function
+} mc_allocator;
+
+
+// Forward declaration of the arena and pool structs
+typedef struct mc_arena_s * mc_arena;
+typedef struct mc_pool_s  * mc_pool;
+
+
+
+
+
+/**
+ * @brief Creates a new bump arena. Memory is requested from the system by blocks of (at least) 'blockSize' bytes, and
+ *        served by moving a cursor forward. Freeing or resizing the most recent allocation is done in place, any
+ *        other free has no effect until the arena is reset.
+ *
+ * @param[in] blockSize  The size of the blocks requested from the system
+ *
+ * @return A pointer to a new arena if operation succeeded, NULL otherwise
+ *
+ * @note   If given size is invalid (i.e. blockSize == 0), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+mc_arena mc_arena_make(size_t blockSize);
+
+/**
+ * @brief Releases every allocation made from the arena at once. The arena keeps its most recent block, to be reused by
+ *        the next allocations. Every object allocated from the arena (vectors included) becomes invalid, and must not
+ *        be freed afterward.
+ *
+ * @param[inout] arena  The arena to be reset. If NULL, this function has no effect
+ */
+void mc_arena_reset(mc_arena arena);
+
+/**
+ * @brief Destroys the arena, and every allocation made from it. Note that if given pointer is NULL, this function has
+ *        no effect
+ *
+ * @param[inout] arena  The arena to be destroyed
+ */
+void mc_arena_free(mc_arena arena);
+
+/**
+ * @brief Gets an allocator serving its allocations from the arena
+ *
+ * @param[in] arena  An arena, which must outlive every user of the allocator
+ *
+ * @return An allocator using the arena as context
+ */
+mc_allocator mc_arena_allocator(mc_arena arena);
+
+
+
+
+
+/**
+ * @brief Creates a new pool of fixed-size blocks. Blocks are requested from the system by chunks of 'blocksPerChunk'
+ *        blocks, and recycled through a free list. Requests bigger than 'blockSize' fail.
+ *
+ * @param[in] blockSize       The size of a block
+ * @param[in] blocksPerChunk  The number of blocks requested from the system at once
+ *
+ * @return A pointer to a new pool if operation succeeded, NULL otherwise
+ *
+ * @note   If given sizes are invalid (i.e. blockSize == 0 or blocksPerChunk == 0), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+mc_pool mc_pool_make(size_t blockSize, size_t blocksPerChunk);
+
+/**
+ * @brief Destroys the pool, and every block allocated from it. Note that if given pointer is NULL, this function has
+ *        no effect
+ *
+ * @param[inout] pool  The pool to be destroyed
+ */
+void mc_pool_free(mc_pool pool);
+
+/**
+ * @brief Gets an allocator serving its allocations from the pool
+ *
+ * @param[in] pool  A pool, which must outlive every user of the allocator
+ *
+ * @return An allocator using the pool as context
+ */
+mc_allocator mc_pool_allocator(mc_pool pool);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Header Guard */
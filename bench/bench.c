@@ -0,0 +1,474 @@
+/**
+ * @file   bench.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Micro-benchmarks of the vector operations, against the same operations on raw arrays (see 'bench.h' for the
+ *         output format). The optional argument is the biggest size of the sweep, in elements.
+ *
+ *         make bench && ./bench/bench > results.csv
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "bench.h"
+
+#define MC_VECTOR_INLINE
+#include "../vector.h"
+
+
+typedef void (*bench_fn)(size_t size, size_t reps, const char *impl, const char *op);
+
+// A vector of 'size' elements, different from each other so that printing does real work
+static vector bench_make_vector(size_t size) {
+    vector res = mc_vector_make(size);
+
+    for (size_t i = 0; i < size; i++)
+        mc_vector_push(res, (long)(i * 2654435761u % 1000000007u) - 500000000);
+
+    return res;
+}
+
+static long *bench_make_array(size_t size) {
+    long *res = (long*)(malloc(size * sizeof (long)));
+
+    for (size_t i = 0; i < size; i++)
+        res[i] = (long)(i * 2654435761u % 1000000007u) - 500000000;
+
+    return res;
+}
+
+
+
+// Construction: a vector created with room for 'size' elements, then destroyed
+static void bench_make_free(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = mc_vector_make(size);
+        mc_bench_sink = (long)(mc_vector_capacity(vec));
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, 1, 0);
+}
+
+// Pushes 'size' elements on a vector created with the smallest capacity (every growth step is taken)
+static void bench_push_grow(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = mc_vector_make(1);
+
+        for (size_t i = 0; i < size; i++)
+            mc_vector_push(vec, (long)(i));
+
+        mc_bench_sink = mc_vector_get_fast(vec, size - 1);
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_push_reserved(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = mc_vector_make(size);
+
+        for (size_t i = 0; i < size; i++)
+            mc_vector_push(vec, (long)(i));
+
+        mc_bench_sink = mc_vector_get_fast(vec, size - 1);
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_push_fast(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = mc_vector_make(1);
+
+        for (size_t i = 0; i < size; i++)
+            mc_vector_push_fast(vec, (long)(i));
+
+        mc_bench_sink = mc_vector_get_fast(vec, size - 1);
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_insert_front(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = mc_vector_make(size);
+
+        // 'mc_vector_insert' needs an element at the index, while 'mc_vector_inserts' also accepts the size
+        for (size_t i = 0; i < size; i++) {
+            long value = (long)(i);
+
+            if (!mc_vector_inserts(vec, 0, &value, 1)) {
+                fprintf(stderr, "%s %s: insertion failed\n", impl, op);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        mc_bench_sink = mc_vector_get_fast(vec, 0);
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_remove_front(size_t size, size_t reps, const char *impl, const char *op) {
+    double elapsed = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        vector vec = bench_make_vector(size);
+        const double start = mc_bench_now();
+
+        while (mc_vector_size(vec) > 1)
+            mc_vector_remove(vec, 0);
+
+        elapsed += mc_bench_now() - start;
+        mc_bench_sink = mc_vector_get_fast(vec, 0);
+        mc_vector_free(vec);
+    }
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_fill(size_t size, size_t reps, const char *impl, const char *op) {
+    vector vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++)
+        mc_vector_fill(vec, (long)(r) + 1);
+
+    const double elapsed = mc_bench_now() - start;
+
+    mc_bench_sink = mc_vector_get_fast(vec, size - 1);
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+// Reads every element through the checked accessor
+static void bench_get_loop(size_t size, size_t reps, const char *impl, const char *op) {
+    vector vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        for (size_t i = 0; i < size; i++) {
+            long value;
+            mc_vector_get(vec, i, &value);
+            sum += value;
+        }
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    mc_bench_sink = sum;
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_foreach(size_t size, size_t reps, const char *impl, const char *op) {
+    vector vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        MC_VECTOR_FOREACH(vec, it)
+            sum += *it;
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    mc_bench_sink = sum;
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_sum(size_t size, size_t reps, const char *impl, const char *op) {
+    vector vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        long value;
+        mc_vector_sum(vec, &value);
+        sum += value;
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    mc_bench_sink = sum;
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_sprint(size_t size, size_t reps, const char *impl, const char *op) {
+    vector vec = bench_make_vector(size);
+    const size_t length = mc_vector_print_length(vec, VDisplay_SingleLine);
+    char *buffer = (char*)(malloc(length + 1));
+
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++)
+        mc_bench_sink = mc_vector_sprint(vec, buffer, (int)(length + 1), VDisplay_SingleLine);
+
+    const double elapsed = mc_bench_now() - start;
+
+    free(buffer);
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(length));
+}
+
+static void bench_fprint(size_t size, size_t reps, const char *impl, const char *op) {
+    FILE *stream = fopen("/dev/null", "w");
+
+    if (!stream)
+        return;
+
+    vector vec = bench_make_vector(size);
+    const size_t length = mc_vector_print_length(vec, VDisplay_OnePerLine);
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++)
+        mc_bench_sink = mc_vector_fprint(vec, stream, VDisplay_OnePerLine);
+
+    const double elapsed = mc_bench_now() - start;
+
+    fclose(stream);
+    mc_vector_free(vec);
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(length));
+}
+
+
+
+// The same operations on raw arrays, the baseline of the library
+
+static void bench_raw_make_free(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        long *array = (long*)(malloc(size * sizeof (long)));
+        mc_bench_sink = (long)((size_t)(array) & 1);
+        free(array);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, 1, 0);
+}
+
+static void bench_raw_push_grow(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        size_t capacity = 1, count = 0;
+        long *array = (long*)(malloc(capacity * sizeof (long)));
+
+        for (size_t i = 0; i < size; i++) {
+            if (count == capacity) {
+                capacity *= 2;
+                array = (long*)(realloc(array, capacity * sizeof (long)));
+            }
+
+            array[count++] = (long)(i);
+        }
+
+        mc_bench_sink = array[size - 1];
+        free(array);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_raw_push_reserved(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        long *array = (long*)(malloc(size * sizeof (long)));
+
+        for (size_t i = 0; i < size; i++)
+            array[i] = (long)(i);
+
+        mc_bench_sink = array[size - 1];
+        free(array);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_raw_insert_front(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        long *array = (long*)(malloc(size * sizeof (long)));
+
+        for (size_t i = 0; i < size; i++) {
+            memmove(array + 1, array, i * sizeof (long));
+            array[0] = (long)(i);
+        }
+
+        mc_bench_sink = array[0];
+        free(array);
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_raw_remove_front(size_t size, size_t reps, const char *impl, const char *op) {
+    double elapsed = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        long *array = bench_make_array(size);
+        const double start = mc_bench_now();
+
+        for (size_t count = size; count > 1; count--)
+            memmove(array, array + 1, (count - 1) * sizeof (long));
+
+        elapsed += mc_bench_now() - start;
+        mc_bench_sink = array[0];
+        free(array);
+    }
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_raw_fill(size_t size, size_t reps, const char *impl, const char *op) {
+    long *array = bench_make_array(size);
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        for (size_t i = 0; i < size; i++)
+            array[i] = (long)(r) + 1;
+
+        mc_bench_sink = array[r % size];
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    free(array);
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_raw_sum(size_t size, size_t reps, const char *impl, const char *op) {
+    long *array = bench_make_array(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        for (size_t i = 0; i < size; i++)
+            sum += array[i];
+
+        mc_bench_sink = sum;
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    free(array);
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+// Printing with snprintf, one element at a time (the way print functions used to work)
+static void bench_raw_sprint(size_t size, size_t reps, const char *impl, const char *op) {
+    long *array = bench_make_array(size);
+    char *buffer = (char*)(malloc(size * 24 + 4));
+    size_t length = 0;
+
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        length = 1;
+        buffer[0] = '{';
+
+        for (size_t i = 0; i < size; i++)
+            length += (size_t)(snprintf(buffer + length, 24, (i + 1 < size) ? "%ld, " : "%ld", array[i]));
+
+        length += (size_t)(snprintf(buffer + length, 3, "}\n"));
+        mc_bench_sink = buffer[length / 2];
+    }
+
+    const double elapsed = mc_bench_now() - start;
+
+    free(buffer);
+    free(array);
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(length));
+}
+
+
+
+typedef struct {
+    const char *impl;
+    const char *op;
+    bench_fn    fn;
+    short       quadratic;                  // Only measured up to MC_BENCH_QUADRATIC_MAX elements
+} bench_case;
+
+static const bench_case bench_cases[] = {
+    { "mc_vector", "make_free",     bench_make_free,        0 },
+    { "mc_vector", "push_grow",     bench_push_grow,        0 },
+    { "mc_vector", "push_reserved", bench_push_reserved,    0 },
+    { "mc_vector", "push_fast",     bench_push_fast,        0 },
+    { "mc_vector", "insert_front",  bench_insert_front,     1 },
+    { "mc_vector", "remove_front",  bench_remove_front,     1 },
+    { "mc_vector", "fill",          bench_fill,             0 },
+    { "mc_vector", "get_loop",      bench_get_loop,         0 },
+    { "mc_vector", "foreach",       bench_foreach,          0 },
+    { "mc_vector", "sum",           bench_sum,              0 },
+    { "mc_vector", "sprint",        bench_sprint,           0 },
+    { "mc_vector", "fprint",        bench_fprint,           0 },
+
+    { "raw",       "make_free",     bench_raw_make_free,    0 },
+    { "raw",       "push_grow",     bench_raw_push_grow,    0 },
+    { "raw",       "push_reserved", bench_raw_push_reserved, 0 },
+    { "raw",       "insert_front",  bench_raw_insert_front, 1 },
+    { "raw",       "remove_front",  bench_raw_remove_front, 1 },
+    { "raw",       "fill",          bench_raw_fill,         0 },
+    { "raw",       "get_loop",      bench_raw_sum,          0 },
+    { "raw",       "sum",           bench_raw_sum,          0 },
+    { "raw",       "sprint",        bench_raw_sprint,       0 }
+};
+
+
+int main(int argc, char **argv) {
+    size_t sizes[MC_BENCH_MAX_SIZES];
+    const size_t nsizes = mc_bench_sizes(sizes, MC_VECTOR_BUFSIZE, mc_bench_max_size(argc, argv));
+
+    mc_bench_header();
+
+    for (size_t c = 0; c < sizeof (bench_cases) / sizeof (bench_cases[0]); c++) {
+        for (size_t s = 0; s < nsizes; s++) {
+            const size_t size = sizes[s];
+
+            if (bench_cases[c].quadratic && size > MC_BENCH_QUADRATIC_MAX)
+                continue;
+
+            // quadratic operations do 'size' times more work per repetition
+            const size_t reps = bench_cases[c].quadratic ? mc_bench_reps(size * size) : mc_bench_reps(size);
+
+            bench_cases[c].fn(size, reps, bench_cases[c].impl, bench_cases[c].op);
+        }
+
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file   bench.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Helpers shared by the benchmarks ('bench.c' for this library and raw arrays, 'bench_std.cpp' for
+ *         std::vector): timer, size sweep and output.
+ *
+ *         Every measure is printed as one CSV line: impl,op,size,reps,ns_per_op,bytes_per_s
+ *         where 'size' is the number of elements of the vector, and an operation is one element pushed, inserted,
+ *         removed, filled, read or printed (one vector for 'make_free'). 'bytes_per_s' counts the elements handled
+ *         (8 bytes each), or the characters written for print operations.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_BENCH_H
+#define MC_BENCH_H
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// The number of element operations a measure aims for, so that small sizes are repeated enough to be timed
+#ifndef MC_BENCH_BUDGET
+#   define MC_BENCH_BUDGET (1 << 22)
+#endif
+
+// Quadratic operations (front insert and remove) are only measured up to this size
+#ifndef MC_BENCH_QUADRATIC_MAX
+#   define MC_BENCH_QUADRATIC_MAX (1 << 14)
+#endif
+
+// The last level cache size (in bytes), used when it cannot be queried at runtime
+#ifndef MC_BENCH_LLC_SIZE
+#   define MC_BENCH_LLC_SIZE (8 << 20)
+#endif
+
+// The biggest size of the sweep is this many times the last level cache
+#define MC_BENCH_LLC_FACTOR 4
+
+#define MC_BENCH_MAX_SIZES 64
+
+// Written by the benchmarks, so that the compiler cannot drop the work being timed
+static volatile long mc_bench_sink;
+
+static double mc_bench_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)(ts.tv_sec) * 1e9 + (double)(ts.tv_nsec);
+}
+
+static size_t mc_bench_llc_size(void) {
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    const long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    if (size > 0)
+        return (size_t)(size);
+#endif
+
+    return MC_BENCH_LLC_SIZE;
+}
+
+// The number of repetitions of a measure on 'size' elements
+static size_t mc_bench_reps(size_t size) {
+    return (size < MC_BENCH_BUDGET) ? MC_BENCH_BUDGET / size : 1;
+}
+
+// Fills 'sizes' with the sweep: 1, around the stack buffer size (inline to heap transition), then powers of 4 up to
+// MC_BENCH_LLC_FACTOR times the last level cache (or 'maxSize' elements if it is not 0). Returns the number of sizes
+static size_t mc_bench_sizes(size_t *sizes, size_t bufsize, size_t maxSize) {
+    const size_t last = maxSize ? maxSize : MC_BENCH_LLC_FACTOR * mc_bench_llc_size() / sizeof (long);
+    size_t count = 0;
+
+    sizes[count++] = 1;
+
+    if (bufsize > 1 && bufsize <= last)
+        sizes[count++] = bufsize;
+
+    if (bufsize + 1 <= last)
+        sizes[count++] = bufsize + 1;
+
+    for (size_t size = 16; size <= last && count < MC_BENCH_MAX_SIZES - 1; size *= 4) {
+        if (size > bufsize + 1)
+            sizes[count++] = size;
+    }
+
+    if (sizes[count - 1] < last)
+        sizes[count++] = last;
+
+    return count;
+}
+
+// Parses the optional arguments: a maximum size (in elements)
+static size_t mc_bench_max_size(int argc, char **argv) {
+    return (argc > 1) ? (size_t)(strtoull(argv[1], NULL, 10)) : 0;
+}
+
+static void mc_bench_header(void) {
+    printf("impl,op,size,reps,ns_per_op,bytes_per_s\n");
+}
+
+// Prints one measure: 'elapsed' nanoseconds for reps * ops operations handling reps * bytes bytes
+static void mc_bench_report(const char *impl, const char *op, size_t size, size_t reps, double elapsed, double ops,
+                            double bytes) {
+    const double total = (double)(reps) * ops;
+
+    printf("%s,%s,%zu,%zu,%.3f,%.0f\n", impl, op, size, reps,
+           (total > 0) ? elapsed / total : 0.0,
+           (elapsed > 0) ? (double)(reps) * bytes * 1e9 / elapsed : 0.0);
+}
+
+#endif /* Header Guard */
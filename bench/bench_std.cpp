@@ -0,0 +1,200 @@
+/**
+ * @file   bench_std.cpp
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  The operations of 'bench.c' on std::vector<long>, printed in the same format (see 'bench.h'), so that both
+ *         outputs can be compared line by line.
+ *
+ *         make bench-std && ./bench/bench_std > results_std.csv
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "bench.h"
+
+#include "../vector.h"      // only for MC_VECTOR_BUFSIZE, so that the sweep is the same
+
+
+typedef void (*bench_fn)(size_t size, size_t reps, const char *impl, const char *op);
+
+static std::vector<long> bench_make_vector(size_t size) {
+    std::vector<long> res(size);
+
+    for (size_t i = 0; i < size; i++)
+        res[i] = (long)(i * 2654435761u % 1000000007u) - 500000000;
+
+    return res;
+}
+
+
+
+static void bench_make_free(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        std::vector<long> vec;
+        vec.reserve(size);
+        mc_bench_sink = (long)(vec.capacity());
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, 1, 0);
+}
+
+static void bench_push_grow(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        std::vector<long> vec;
+
+        for (size_t i = 0; i < size; i++)
+            vec.push_back((long)(i));
+
+        mc_bench_sink = vec.back();
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_push_reserved(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        std::vector<long> vec;
+        vec.reserve(size);
+
+        for (size_t i = 0; i < size; i++)
+            vec.push_back((long)(i));
+
+        mc_bench_sink = vec.back();
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_insert_front(size_t size, size_t reps, const char *impl, const char *op) {
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        std::vector<long> vec;
+        vec.reserve(size);
+
+        for (size_t i = 0; i < size; i++)
+            vec.insert(vec.begin(), (long)(i));
+
+        mc_bench_sink = vec.front();
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_remove_front(size_t size, size_t reps, const char *impl, const char *op) {
+    double elapsed = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        std::vector<long> vec = bench_make_vector(size);
+        const double start = mc_bench_now();
+
+        while (vec.size() > 1)
+            vec.erase(vec.begin());
+
+        elapsed += mc_bench_now() - start;
+        mc_bench_sink = vec.front();
+    }
+
+    mc_bench_report(impl, op, size, reps, elapsed, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_fill(size_t size, size_t reps, const char *impl, const char *op) {
+    std::vector<long> vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+
+    for (size_t r = 0; r < reps; r++) {
+        std::fill(vec.begin(), vec.end(), (long)(r) + 1);
+        mc_bench_sink = vec[r % size];
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_get_loop(size_t size, size_t reps, const char *impl, const char *op) {
+    std::vector<long> vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        for (size_t i = 0; i < size; i++)
+            sum += vec.at(i);
+
+        mc_bench_sink = sum;
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+static void bench_sum(size_t size, size_t reps, const char *impl, const char *op) {
+    std::vector<long> vec = bench_make_vector(size);
+    const double start = mc_bench_now();
+    long sum = 0;
+
+    for (size_t r = 0; r < reps; r++) {
+        sum += std::accumulate(vec.begin(), vec.end(), 0L);
+        mc_bench_sink = sum;
+    }
+
+    mc_bench_report(impl, op, size, reps, mc_bench_now() - start, (double)(size), (double)(size * sizeof (long)));
+}
+
+
+
+struct bench_case {
+    const char *impl;
+    const char *op;
+    bench_fn    fn;
+    short       quadratic;                  // Only measured up to MC_BENCH_QUADRATIC_MAX elements
+};
+
+static const bench_case bench_cases[] = {
+    { "std_vector", "make_free",     bench_make_free,       0 },
+    { "std_vector", "push_grow",     bench_push_grow,       0 },
+    { "std_vector", "push_reserved", bench_push_reserved,   0 },
+    { "std_vector", "insert_front",  bench_insert_front,    1 },
+    { "std_vector", "remove_front",  bench_remove_front,    1 },
+    { "std_vector", "fill",          bench_fill,            0 },
+    { "std_vector", "get_loop",      bench_get_loop,        0 },
+    { "std_vector", "sum",           bench_sum,             0 }
+};
+
+
+int main(int argc, char **argv) {
+    size_t sizes[MC_BENCH_MAX_SIZES];
+    const size_t nsizes = mc_bench_sizes(sizes, MC_VECTOR_BUFSIZE, mc_bench_max_size(argc, argv));
+
+    mc_bench_header();
+
+    for (size_t c = 0; c < sizeof (bench_cases) / sizeof (bench_cases[0]); c++) {
+        for (size_t s = 0; s < nsizes; s++) {
+            const size_t size = sizes[s];
+
+            if (bench_cases[c].quadratic && size > MC_BENCH_QUADRATIC_MAX)
+                continue;
+
+            const size_t reps = bench_cases[c].quadratic ? mc_bench_reps(size * size) : mc_bench_reps(size);
+
+            bench_cases[c].fn(size, reps, bench_cases[c].impl, bench_cases[c].op);
+        }
+
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+/**
+ * @file   cvector.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Implementation of the concurrent vector (see cvector.h). Requires C11 atomics.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "cvector.h"
+#include "vector_segment.h"
+
+#if (MC_CVECTOR_SEGMENT & (MC_CVECTOR_SEGMENT - 1)) != 0 || MC_CVECTOR_SEGMENT < 1
+#   error "MC_CVECTOR_SEGMENT must be a power of two"
+#endif
+
+
+// Segment layout (see vector_segment.h)
+#define CVEC_MAX_SEGMENTS               VSEG_MAX_SEGMENTS
+#define cvec_segment_size(k)            vseg_size(MC_CVECTOR_SEGMENT, k)
+#define cvec_locate(index, offset)      vseg_locate(index, MC_CVECTOR_SEGMENT, offset)
+
+// Keeps the two counters on different cache lines, since they are written by different threads
+#define CVEC_CACHE_LINE 64
+
+
+struct cvector_s {
+    _Atomic size_t reserved;                            // The number of slots handed out to appends
+    char pad1[CVEC_CACHE_LINE - sizeof (size_t)];
+
+    _Atomic size_t ready;                               // A prefix of slots known to be written (advanced lazily)
+    char pad2[CVEC_CACHE_LINE - sizeof (size_t)];
+
+    _Atomic(long*) segments[CVEC_MAX_SEGMENTS];         // Segment k holds (MC_CVECTOR_SEGMENT << k) elements
+};
+
+// Every segment is followed by one flag per slot, set once the element of the slot has been written
+#define cvec_flags(data, segment) ((atomic_uchar*)((data) + cvec_segment_size(segment)))
+
+
+// Gets a segment (and its flags), allocating it if no thread did it yet. Returns NULL if allocation fails
+static long *cvec_segment(cvector cvec, size_t segment) {
+    long *res = atomic_load_explicit(&cvec->segments[segment], memory_order_acquire);
+
+    if (res)
+        return res;
+
+    if (segment >= CVEC_MAX_SEGMENTS - vseg_log2(MC_CVECTOR_SEGMENT))
+        return NULL;
+
+    const size_t length = cvec_segment_size(segment);
+
+    if (length > SIZE_MAX / (sizeof (long) + 1) || !(res = (long*)(malloc(length * (sizeof (long) + 1)))))
+        return NULL;
+
+    atomic_uchar *flags = cvec_flags(res, segment);
+
+    for (size_t i = 0; i < length; i++)
+        atomic_init(&flags[i], 0);
+
+    long *expected = NULL;
+
+    if (!atomic_compare_exchange_strong_explicit(&cvec->segments[segment], &expected, res,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        // another thread installed it first
+        free(res);
+        return expected;
+    }
+
+    return res;
+}
+
+// Makes sure the segments of the slots [index, index + length) exist, returns 0 if one of them cannot be allocated
+static short cvec_prepare(cvector cvec, size_t index, size_t length) {
+    size_t offset;
+    const size_t first = cvec_locate(index, &offset);
+    const size_t last = cvec_locate(index + length - 1, &offset);
+
+    for (size_t segment = first; segment <= last; segment++) {
+        if (!cvec_segment(cvec, segment))
+            return 0;
+    }
+
+    return 1;
+}
+
+// Copies elements to the slots [index, index + length) and marks them as written. The segments must exist
+static void cvec_store(cvector cvec, size_t index, const long *src, size_t length) {
+    while (length > 0) {
+        size_t offset;
+        const size_t segment = cvec_locate(index, &offset);
+        const size_t n = (cvec_segment_size(segment) - offset < length)
+                       ? cvec_segment_size(segment) - offset
+                       : length;
+
+        long *data = atomic_load_explicit(&cvec->segments[segment], memory_order_acquire);
+        atomic_uchar *flags = cvec_flags(data, segment);
+
+        memcpy(data + offset, src, n * sizeof (long));
+
+        for (size_t i = 0; i < n; i++)
+            atomic_store_explicit(&flags[offset + i], 1, memory_order_release);
+
+        index += n;
+        src += n;
+        length -= n;
+    }
+}
+
+// Advances the prefix of written slots as far as possible (but not past 'count'), and returns it
+static size_t cvec_ready_prefix(cvector cvec, size_t count) {
+    const size_t start = atomic_load_explicit(&cvec->ready, memory_order_acquire);
+    size_t index = start;
+
+    while (index < count) {
+        size_t offset;
+        const size_t segment = cvec_locate(index, &offset);
+        const long *data = atomic_load_explicit(&cvec->segments[segment], memory_order_acquire);
+
+        if (!data || !atomic_load_explicit(&cvec_flags(data, segment)[offset], memory_order_acquire))
+            break;
+
+        index++;
+    }
+
+    size_t current = start;
+
+    // other readers may have gone further
+    while (index > current
+           && !atomic_compare_exchange_weak_explicit(&cvec->ready, &current, index,
+                                                     memory_order_release, memory_order_acquire))
+        ;
+
+    return (index > current) ? index : current;
+}
+
+cvector mc_cvector_make(size_t capacity) {
+    cvector res = (cvector)(malloc(sizeof (struct cvector_s)));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    atomic_init(&res->reserved, 0);
+    atomic_init(&res->ready, 0);
+
+    for (size_t i = 0; i < CVEC_MAX_SEGMENTS; i++)
+        atomic_init(&res->segments[i], NULL);
+
+    if (capacity > SIZE_MAX / sizeof (long) - MC_CVECTOR_SEGMENT) {
+        free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    if (capacity > 0) {
+        size_t offset;
+        const size_t last = cvec_locate(capacity - 1, &offset);
+
+        for (size_t i = 0; i <= last; i++) {
+            if (!cvec_segment(res, i)) {
+                mc_cvector_free(res);
+                errno = ENOBUFS;
+                return NULL;
+            }
+        }
+    }
+
+    return res;
+}
+
+void mc_cvector_free(cvector cvec) {
+    if (!cvec)
+        return;
+
+    for (size_t i = 0; i < CVEC_MAX_SEGMENTS; i++)
+        free(atomic_load_explicit(&cvec->segments[i], memory_order_relaxed));
+
+    free(cvec);
+}
+
+short mc_cvector_push(cvector cvec, long value) {
+    return mc_cvector_append(cvec, &value, 1);
+}
+
+short mc_cvector_append(cvector cvec, const long *src, size_t length) {
+    if (!cvec || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (length == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    const size_t maxCount = SIZE_MAX / sizeof (long) - MC_CVECTOR_SEGMENT;
+    size_t index = atomic_load_explicit(&cvec->reserved, memory_order_relaxed);
+
+    // the slots are only reserved once the bound is checked and their segments exist, so that a failed append
+    // leaves no slot behind (a failed exchange reloads 'index', and everything is checked again)
+    do {
+        if (length > maxCount - index) {
+            errno = ENOMEM;
+            return 0;
+        }
+
+        if (!cvec_prepare(cvec, index, length)) {
+            errno = ENOBUFS;
+            return 0;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&cvec->reserved, &index, index + length,
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    // nothing to wait for: readers check the flag of every slot
+    cvec_store(cvec, index, src, length);
+    return 1;
+}
+
+short mc_cvector_get(cvector cvec, size_t index, long *out) {
+    if (!cvec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= atomic_load_explicit(&cvec->reserved, memory_order_relaxed)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    size_t offset;
+    const size_t segment = cvec_locate(index, &offset);
+    const long *data = atomic_load_explicit(&cvec->segments[segment], memory_order_acquire);
+
+    if (!data || !atomic_load_explicit(&cvec_flags(data, segment)[offset], memory_order_acquire)) {
+        errno = EAGAIN;
+        return 0;
+    }
+
+    *out = data[offset];
+    return 1;
+}
+
+size_t mc_cvector_size(cvector cvec) {
+    if (!cvec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return atomic_load_explicit(&cvec->reserved, memory_order_relaxed);
+}
+
+vector mc_cvector_to_vector(cvector cvec) {
+    if (!cvec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    const size_t count = cvec_ready_prefix(cvec, atomic_load_explicit(&cvec->reserved, memory_order_acquire));
+    vector res = mc_vector_make((count > 0) ? count : 1);
+
+    if (!res)
+        return NULL;
+
+    for (size_t index = 0, segment = 0; index < count; segment++) {
+        const size_t length = cvec_segment_size(segment);
+        const size_t n = (count - index < length) ? count - index : length;
+        const long *data = atomic_load_explicit(&cvec->segments[segment], memory_order_acquire);
+
+        if (!data || !mc_vector_append(res, data, n)) {
+            mc_vector_free(res);
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        index += n;
+    }
+
+    return res;
+}
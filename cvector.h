@@ -0,0 +1,166 @@
+/**
+ * @file   cvector.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  A vector of longs which can be appended to by several threads at once, without any lock.
+ *
+ *         Elements are stored on segments which are never moved nor reallocated: segment k holds
+ *         (MC_CVECTOR_SEGMENT << k) elements, so that the address of a published element stays valid for the whole
+ *         life of the vector. An append allocates the segments its slots land on if no other thread did it first (the
+ *         only call which may lock, inside malloc), reserves its slots with an atomic compare-exchange on the number
+ *         of elements, writes its elements, and sets the ready flag of each of their slots. It never waits for other
+ *         appends: an element can be read by any thread as soon as its own append has written it, even if an earlier
+ *         slot is still being written. Each slot costs one extra byte for its flag.
+ *
+ *         Producers appending many elements should batch them locally and call 'mc_cvector_append', which reserves
+ *         the whole range at once.
+ *
+ *         This file requires C11 atomics (<stdatomic.h>) to be compiled, but its header only exposes an opaque type.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_CVECTOR_H
+#define MC_CVECTOR_H
+
+#include <stddef.h>
+
+#include "vector.h"
+
+// The number of elements of the first segment, must be a power of two
+#ifndef MC_CVECTOR_SEGMENT
+#   define MC_CVECTOR_SEGMENT 64
+#endif
+
+
+#ifndef MC_VECTOR_NO_MACROS
+
+#define cvmake(capacity)                    mc_cvector_make(capacity)
+#define cvfree(cvec)                        mc_cvector_free(cvec)
+
+#define cvpush(cvec, value)                 mc_cvector_push(cvec, value)
+#define cvappend(cvec, src, len)            mc_cvector_append(cvec, src, len)
+
+#define cvget(cvec, index, out)             mc_cvector_get(cvec, index, out)
+#define cvsize(cvec)                        mc_cvector_size(cvec)
+#define cvtovec(cvec)                       mc_cvector_to_vector(cvec)
+
+#endif /* MC_VECTOR_NO_MACROS */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declaration of the concurrent vector struct
+typedef struct cvector_s * cvector;
+
+
+
+
+
+/**
+ * @brief Creates a new concurrent vector. The segments needed to hold 'capacity' elements are allocated upfront, so
+ *        that appends below this capacity never allocate.
+ *
+ * @param[in] capacity  The number of elements to allocate room for (may be 0)
+ *
+ * @return A pointer to a new concurrent vector if operation succeeded, NULL otherwise
+ *
+ * @note   If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+cvector mc_cvector_make(size_t capacity);
+
+/**
+ * @brief Destroys the concurrent vector. No other thread may use it anymore. Note that if given pointer is NULL, this
+ *        function has no effect
+ *
+ * @param[inout] cvec  The concurrent vector to be destroyed
+ */
+void mc_cvector_free(cvector cvec);
+
+/**
+ * @brief Appends an element at the end of the concurrent vector. This function can be called by several threads at
+ *        once, and returns as soon as the element is written: other threads can read it from then on.
+ *
+ * @param[inout] cvec   The concurrent vector
+ * @param[in]    value  The element to be added
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If the vector is full (i.e. its size would overflow), [errno] will be set to @c ENOMEM
+ *         If a segment cannot be allocated, [errno] will be set to @c ENOBUFS, and no slot is reserved
+ */
+short mc_cvector_push(cvector cvec, long value);
+
+/**
+ * @brief Appends several elements at the end of the concurrent vector, with a single reservation. The elements are
+ *        stored contiguously (their indices follow each other), even if other threads append at the same time.
+ *
+ * @param[inout] cvec    The concurrent vector
+ * @param[in]    src     The elements to be added
+ * @param[in]    length  The number of elements to be added
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector or src is NULL, [errno] will be set to @c EFAULT
+ *         If length is invalid (i.e. length == 0), [errno] will be set to @c EINVAL
+ *         If the vector is full (i.e. its size would overflow), [errno] will be set to @c ENOMEM
+ *         If a segment cannot be allocated, [errno] will be set to @c ENOBUFS (see 'mc_cvector_push')
+ */
+short mc_cvector_append(cvector cvec, const long *src, size_t length);
+
+/**
+ * @brief Gets an element, if its append has written it. This function can be called while other threads append.
+ *
+ * @param[in]  cvec   The concurrent vector
+ * @param[in]  index  The index of the element, which must be below 'mc_cvector_size'
+ * @param[out] out    Where the element is stored
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector or out is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ *         If the element is not written yet (its append is still running), [errno] will be set to @c EAGAIN
+ */
+short mc_cvector_get(cvector cvec, size_t index, long *out);
+
+/**
+ * @brief Gets the number of slots reserved by appends. Every append which has returned has its elements below this
+ *        index, but slots of appends still running are counted as well (see 'mc_cvector_get').
+ *
+ * @param[in] cvec  The concurrent vector
+ *
+ * @return The number of reserved slots
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_cvector_size(cvector cvec);
+
+/**
+ * @brief Copies the elements into a new (regular) vector, up to the first slot which is not written yet (see
+ *        'mc_cvector_get'). Once every append has returned, this is every element. Elements appended while copying
+ *        may be missed.
+ *
+ * @param[in] cvec  The concurrent vector
+ *
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_cvector_to_vector(cvector cvec);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Header Guard */
@@ -0,0 +1,387 @@
+/**
+ * @file   pvector.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Implementation of the compressed vector (see pvector.h)
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+
+#define MC_VECTOR_INLINE
+#include "pvector.h"
+
+#if MC_PVECTOR_BLOCK < 2 || MC_PVECTOR_BLOCK > 256
+#   error "MC_PVECTOR_BLOCK must be between 2 and 256"
+#endif
+
+#if ULONG_MAX > UINT64_MAX
+#   error "unsigned long must fit on 64 bits"
+#endif
+
+
+// Elements are handled as unsigned longs, so that differences wrap around instead of overflowing
+#define PVEC_BITS (sizeof (unsigned long) * CHAR_BIT)
+
+// Flipping the sign bit maps the order of signed differences to the order of unsigned integers
+#define PVEC_SIGN ((unsigned long)(1) << (PVEC_BITS - 1))
+
+// A block is made of 64-bit words:
+//  - the first element, the smallest (sign-flipped) difference, and the number of elements, width and exceptions,
+//  - the differences minus the smallest one, packed on 'width' bits each,
+//  - the positions of the exceptions (one byte each), then the bits of every exception above 'width' (one word each)
+#define PVEC_HEADER_WORDS 3
+
+// The number of frames of reference tried on every block
+#define PVEC_CANDIDATES 4
+
+#define pvec_words(bits) (((bits) + 63) / 64)
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+
+struct pvector_s {
+    size_t    count;                            // The number of elements
+    size_t    nblocks;                          // The number of blocks
+    size_t   *index;                            // The offset of every block on words (nblocks + 1 entries)
+    uint64_t *words;                            // The encoded blocks
+};
+
+
+static unsigned int pvec_bit_length(unsigned long x) {
+#if defined(__GNUC__)
+    return x ? (unsigned int)(sizeof (unsigned long long) * CHAR_BIT) - (unsigned int)(__builtin_clzll(x)) : 0;
+#else
+    unsigned int res = 0;
+
+    while (x) {
+        x >>= 1;
+        res++;
+    }
+
+    return res;
+#endif
+}
+
+// The encoding of a block
+typedef struct {
+    unsigned long base;                         // The frame of reference, subtracted from every difference
+    unsigned int  width;                        // The number of bits of a packed difference
+    size_t        exceptions;                   // The number of differences which do not fit on 'width' bits
+    size_t        words;                        // The size of the block, in words
+} pvec_frame;
+
+// Computes the (sign-flipped) differences of a block
+static void pvec_deltas(const long *src, size_t length, unsigned long *keys) {
+    for (size_t i = 1; i < length; i++)
+        keys[i - 1] = ((unsigned long)(src[i]) - (unsigned long)(src[i - 1])) ^ PVEC_SIGN;
+}
+
+// Chooses the width giving the smallest block (exceptions included) for a given frame of reference
+static void pvec_plan(const unsigned long *keys, size_t length, unsigned long base, pvec_frame *frame) {
+    size_t histogram[PVEC_BITS + 1] = { 0 };
+
+    for (size_t i = 0; i < length; i++)
+        histogram[pvec_bit_length(keys[i] - base)]++;
+
+    size_t exceptions = length;
+
+    frame->base = base;
+    frame->words = SIZE_MAX;
+
+    for (unsigned int width = 0; width <= PVEC_BITS; width++) {
+        exceptions -= histogram[width];
+
+        const size_t words = PVEC_HEADER_WORDS + pvec_words(length * width) + pvec_words(exceptions * 8) + exceptions;
+
+        if (words <= frame->words) {
+            frame->words = words;
+            frame->width = width;
+            frame->exceptions = exceptions;
+        }
+    }
+}
+
+// Chooses the frame of reference of a block. The smallest difference is the natural one, but a single difference much
+// smaller than the others would widen the whole block: the few smallest differences are tried, those below the chosen
+// one wrap around and become exceptions
+static pvec_frame pvec_choose(const unsigned long *keys, size_t length) {
+    unsigned long candidates[PVEC_CANDIDATES];
+    size_t ncandidates = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        // insertion into the sorted list of the smallest differences
+        size_t pos = ncandidates;
+
+        while (pos > 0 && candidates[pos - 1] > keys[i])
+            pos--;
+
+        if (pos >= PVEC_CANDIDATES)
+            continue;
+
+        const size_t last = (ncandidates < PVEC_CANDIDATES) ? ncandidates++ : PVEC_CANDIDATES - 1;
+
+        memmove(candidates + pos + 1, candidates + pos, (last - pos) * sizeof (unsigned long));
+        candidates[pos] = keys[i];
+    }
+
+    pvec_frame res, frame;
+
+    pvec_plan(keys, length, ncandidates ? candidates[0] : 0, &res);
+
+    for (size_t i = 1; i < ncandidates; i++) {
+        pvec_plan(keys, length, candidates[i], &frame);
+
+        if (frame.words < res.words)
+            res = frame;
+    }
+
+    return res;
+}
+
+static void pvec_encode(const long *src, size_t length, uint64_t *dst) {
+    unsigned long keys[MC_PVECTOR_BLOCK];
+
+    pvec_deltas(src, length, keys);
+
+    const pvec_frame frame = pvec_choose(keys, length - 1);
+    const unsigned int width = frame.width;
+
+    memset(dst, 0, frame.words * sizeof (uint64_t));
+
+    dst[0] = (uint64_t)((unsigned long)(src[0]));
+    dst[1] = (uint64_t)(frame.base);
+    dst[2] = (uint64_t)(length) | ((uint64_t)(width) << 16) | ((uint64_t)(frame.exceptions) << 32);
+
+    uint64_t *packed = dst + PVEC_HEADER_WORDS;
+    unsigned char *positions = (unsigned char*)(packed + pvec_words((length - 1) * width));
+    uint64_t *highs = (uint64_t*)(positions) + pvec_words(frame.exceptions * 8);
+    const uint64_t mask = (width < 64) ? ((uint64_t)(1) << width) - 1 : ~(uint64_t)(0);
+
+    for (size_t i = 0, e = 0; i < length - 1; i++) {
+        const uint64_t value = (uint64_t)(keys[i] - frame.base);
+
+        if (width < 64 && (value >> width) != 0) {
+            positions[e] = (unsigned char)(i);
+            highs[e++] = value >> width;
+        }
+
+        if (width == 0)
+            continue;
+
+        const size_t bit = i * width;
+        const unsigned int shift = (unsigned int)(bit & 63);
+
+        packed[bit >> 6] |= (value & mask) << shift;
+
+        if (shift + width > 64)
+            packed[(bit >> 6) + 1] |= (value & mask) >> (64 - shift);
+    }
+}
+
+// Decodes the first 'length' elements of a block (at most the number of elements of the block), returns the number
+// of elements of the block
+static size_t pvec_decode(const uint64_t *src, long *out, size_t length) {
+    const size_t count = (size_t)(src[2] & 0xFFFF);
+    const unsigned int width = (unsigned int)((src[2] >> 16) & 0xFF);
+    const size_t exceptions = (size_t)((src[2] >> 32) & 0xFFFF);
+
+    const uint64_t *packed = src + PVEC_HEADER_WORDS;
+    const unsigned char *positions = (const unsigned char*)(packed + pvec_words((count - 1) * width));
+    const uint64_t *highs = (const uint64_t*)(positions) + pvec_words(exceptions * 8);
+    const uint64_t mask = (width < 64) ? ((uint64_t)(1) << width) - 1 : ~(uint64_t)(0);
+
+    unsigned long deltas[MC_PVECTOR_BLOCK];
+    const size_t n = (length < count) ? length - 1 : count - 1;
+
+    if (width == 0) {
+        memset(deltas, 0, n * sizeof (unsigned long));
+    }
+    else {
+        for (size_t i = 0; i < n; i++) {
+            const size_t bit = i * width;
+            const unsigned int shift = (unsigned int)(bit & 63);
+            uint64_t value = packed[bit >> 6] >> shift;
+
+            if (shift + width > 64)
+                value |= packed[(bit >> 6) + 1] << (64 - shift);
+
+            deltas[i] = (unsigned long)(value & mask);
+        }
+    }
+
+    for (size_t e = 0; e < exceptions; e++) {
+        if (positions[e] < n)
+            deltas[positions[e]] |= (unsigned long)(highs[e] << width);
+    }
+
+    // prefix sum of the differences
+    const unsigned long base = (unsigned long)(src[1]);
+    unsigned long prev = (unsigned long)(src[0]);
+
+    out[0] = (long)(prev);
+
+    for (size_t i = 0; i < n; i++) {
+        prev += (deltas[i] + base) ^ PVEC_SIGN;
+        out[i + 1] = (long)(prev);
+    }
+
+    return count;
+}
+
+
+pvector mc_vector_compress(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    pvector res = (pvector)(malloc(sizeof (struct pvector_s)));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    res->count = vec->count;
+    res->nblocks = (vec->count + MC_PVECTOR_BLOCK - 1) / MC_PVECTOR_BLOCK;
+    res->words = NULL;
+    res->index = (size_t*)(malloc((res->nblocks + 1) * sizeof (size_t)));
+
+    if (!res->index) {
+        mc_pvector_free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    // first pass: size of every block
+    unsigned long keys[MC_PVECTOR_BLOCK];
+
+    res->index[0] = 0;
+
+    for (size_t k = 0; k < res->nblocks; k++) {
+        const long *src = vec->data + k * MC_PVECTOR_BLOCK;
+        const size_t length = min(vec->count - k * MC_PVECTOR_BLOCK, (size_t)(MC_PVECTOR_BLOCK));
+
+        pvec_deltas(src, length, keys);
+        res->index[k + 1] = res->index[k] + pvec_choose(keys, length - 1).words;
+    }
+
+    res->words = (uint64_t*)(malloc((res->index[res->nblocks] > 0 ? res->index[res->nblocks] : 1) * sizeof (uint64_t)));
+
+    if (!res->words) {
+        mc_pvector_free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    // second pass: encoding
+    for (size_t k = 0; k < res->nblocks; k++) {
+        const size_t length = min(vec->count - k * MC_PVECTOR_BLOCK, (size_t)(MC_PVECTOR_BLOCK));
+
+        pvec_encode(vec->data + k * MC_PVECTOR_BLOCK, length, res->words + res->index[k]);
+    }
+
+    return res;
+}
+
+vector mc_vector_decompress(pvector pvec) {
+    if (!pvec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    vector res = mc_vector_make((pvec->count > 0) ? pvec->count : 1);
+
+    if (!res)
+        return NULL;
+
+    // blocks are decoded in place
+    for (size_t k = 0; k < pvec->nblocks; k++)
+        pvec_decode(pvec->words + pvec->index[k], res->data + k * MC_PVECTOR_BLOCK, MC_PVECTOR_BLOCK);
+
+    res->count = pvec->count;
+    return res;
+}
+
+void mc_pvector_free(pvector pvec) {
+    if (!pvec)
+        return;
+
+    free(pvec->index);
+    free(pvec->words);
+    free(pvec);
+}
+
+size_t mc_pvector_size(pvector pvec) {
+    if (!pvec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return pvec->count;
+}
+
+size_t mc_pvector_bytes(pvector pvec) {
+    if (!pvec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return sizeof (struct pvector_s) + (pvec->nblocks + 1) * sizeof (size_t)
+         + pvec->index[pvec->nblocks] * sizeof (uint64_t);
+}
+
+short mc_pvector_get(pvector pvec, size_t index, long *out) {
+    if (!pvec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= pvec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    long buffer[MC_PVECTOR_BLOCK];
+    const size_t block = index / MC_PVECTOR_BLOCK, offset = index % MC_PVECTOR_BLOCK;
+
+    pvec_decode(pvec->words + pvec->index[block], buffer, offset + 1);
+
+    *out = buffer[offset];
+    return 1;
+}
+
+size_t mc_pvector_blocks(pvector pvec) {
+    if (!pvec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return pvec->nblocks;
+}
+
+size_t mc_pvector_decode_block(pvector pvec, size_t block, long *out) {
+    if (!pvec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (block >= pvec->nblocks) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    return pvec_decode(pvec->words + pvec->index[block], out, MC_PVECTOR_BLOCK);
+}
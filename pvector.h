@@ -0,0 +1,165 @@
+/**
+ * @file   pvector.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  A frozen, compressed copy of a vector, for big lists of integers which are mostly scanned (sorted ids,
+ *         counters): elements which fit on a few bits take a few bits instead of a whole long.
+ *
+ *         Elements are split into blocks of MC_PVECTOR_BLOCK elements. Every block stores its first element, then the
+ *         differences between consecutive elements (delta encoding), minus the smallest difference of the block
+ *         (frame of reference), packed on the fewest bits which hold most of them. The few differences needing more
+ *         bits are stored as exceptions, patched after unpacking (PFOR), so that an outlier does not widen the whole
+ *         block. Sorted or slowly varying data compresses best.
+ *
+ *         A block index gives the position of every block: an element is read by decoding the start of its block,
+ *         and scans decode one block at a time ('mc_pvector_decode_block'). A compressed vector cannot be modified,
+ *         'mc_vector_decompress' gives back a regular vector.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_PVECTOR_H
+#define MC_PVECTOR_H
+
+#include <stddef.h>
+
+#include "vector.h"
+
+// The number of elements of a block (at most 256)
+#ifndef MC_PVECTOR_BLOCK
+#   define MC_PVECTOR_BLOCK 128
+#endif
+
+
+#ifndef MC_VECTOR_NO_MACROS
+
+#define vcompress(vec)                      mc_vector_compress(vec)
+#define vdecompress(pvec)                   mc_vector_decompress(pvec)
+
+#define pvfree(pvec)                        mc_pvector_free(pvec)
+#define pvsize(pvec)                        mc_pvector_size(pvec)
+#define pvbytes(pvec)                       mc_pvector_bytes(pvec)
+#define pvget(pvec, index, out)             mc_pvector_get(pvec, index, out)
+#define pvblocks(pvec)                      mc_pvector_blocks(pvec)
+#define pvdecode(pvec, block, out)          mc_pvector_decode_block(pvec, block, out)
+
+#endif /* MC_VECTOR_NO_MACROS */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declaration of the compressed vector struct
+typedef struct pvector_s * pvector;
+
+
+
+
+
+/**
+ * @brief Creates a compressed copy of the vector. The vector itself is left untouched.
+ *
+ * @param[in] vec  The vector to be compressed (may be empty)
+ *
+ * @return A pointer to a new compressed vector if operation succeeded, NULL otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+pvector mc_vector_compress(vector vec);
+
+/**
+ * @brief Decodes a compressed vector into a new (regular) vector
+ *
+ * @param[in] pvec  The compressed vector
+ *
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ *
+ * @note   If compressed vector is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_vector_decompress(pvector pvec);
+
+/**
+ * @brief Destroys the compressed vector. Note that if given pointer is NULL, this function has no effect
+ *
+ * @param[inout] pvec  The compressed vector to be destroyed
+ */
+void mc_pvector_free(pvector pvec);
+
+/**
+ * @brief Gets the number of elements of the compressed vector
+ *
+ * @param[in] pvec  The compressed vector
+ *
+ * @return The number of elements
+ *
+ * @note   If compressed vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_pvector_size(pvector pvec);
+
+/**
+ * @brief Gets the memory used by the compressed vector (blocks, block index and header), in bytes
+ *
+ * @param[in] pvec  The compressed vector
+ *
+ * @return The number of bytes used by the compressed vector
+ *
+ * @note   If compressed vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_pvector_bytes(pvector pvec);
+
+/**
+ * @brief Gets an element from the compressed vector. The block of the element is found through the block index, and
+ *        decoded up to the element (at most MC_PVECTOR_BLOCK elements): prefer 'mc_pvector_decode_block' for scans.
+ *
+ * @param[in]  pvec   The compressed vector
+ * @param[in]  index  The position of the element
+ * @param[out] out    Where the element is stored
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If compressed vector or out is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ */
+short mc_pvector_get(pvector pvec, size_t index, long *out);
+
+/**
+ * @brief Gets the number of blocks of the compressed vector. Block k holds the elements
+ *        [k * MC_PVECTOR_BLOCK, (k + 1) * MC_PVECTOR_BLOCK), the last one may be shorter.
+ *
+ * @param[in] pvec  The compressed vector
+ *
+ * @return The number of blocks
+ *
+ * @note   If compressed vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_pvector_blocks(pvector pvec);
+
+/**
+ * @brief Decodes a whole block of the compressed vector
+ *
+ * @param[in]  pvec   The compressed vector
+ * @param[in]  block  The index of the block
+ * @param[out] out    An array which can hold MC_PVECTOR_BLOCK elements
+ *
+ * @return The number of elements stored into the array, 0 if operation failed
+ *
+ * @note   If compressed vector or out is NULL, [errno] will be set to @c EFAULT
+ *         If block is invalid (i.e. block >= number of blocks), [errno] will be set to @c EINVAL
+ */
+size_t mc_pvector_decode_block(pvector pvec, size_t block, long *out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Header Guard */
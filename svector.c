@@ -0,0 +1,261 @@
+/**
+ * @file   svector.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Implementation of the segmented vector (see svector.h)
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "svector.h"
+#include "vector_segment.h"
+
+#if (MC_SVECTOR_SEGMENT & (MC_SVECTOR_SEGMENT - 1)) != 0 || MC_SVECTOR_SEGMENT < 1
+#   error "MC_SVECTOR_SEGMENT must be a power of two"
+#endif
+
+
+// Segment layout (see vector_segment.h)
+#define SVEC_MAX_SEGMENTS               VSEG_MAX_SEGMENTS
+#define svec_segment_size(k)            vseg_size(MC_SVECTOR_SEGMENT, k)
+#define svec_locate(index, offset)      vseg_locate(index, MC_SVECTOR_SEGMENT, offset)
+
+
+struct svector_s {
+    size_t count;                               // The number of elements stored on the vector
+    size_t nsegments;                           // The number of allocated segments (the first one included)
+    long  *segments[SVEC_MAX_SEGMENTS];         // Segment k holds (MC_SVECTOR_SEGMENT << k) elements
+    long   first[MC_SVECTOR_SEGMENT];           // The first segment, allocated along with the vector
+};
+
+
+// Allocates the segments needed to hold 'length' elements, existing segments are left untouched
+static short svec_reserve(svector svec, size_t length) {
+    if (length == 0)
+        return 1;
+
+    size_t offset;
+    const size_t last = svec_locate(length - 1, &offset);
+
+    while (svec->nsegments <= last) {
+        const size_t size = svec_segment_size(svec->nsegments);
+        long *segment = (size <= SIZE_MAX / sizeof (long)) ? (long*)(malloc(size * sizeof (long))) : NULL;
+
+        if (!segment)
+            return 0;
+
+        svec->segments[svec->nsegments++] = segment;
+    }
+
+    return 1;
+}
+
+
+svector mc_svector_make(size_t capacity) {
+    svector res = (svector)(malloc(sizeof (struct svector_s)));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    res->count = 0;
+    res->nsegments = 1;
+    res->segments[0] = res->first;
+
+    if (capacity > SIZE_MAX / sizeof (long) - MC_SVECTOR_SEGMENT || !svec_reserve(res, capacity)) {
+        mc_svector_free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    return res;
+}
+
+void mc_svector_free(svector svec) {
+    if (!svec)
+        return;
+
+    for (size_t i = 1; i < svec->nsegments; i++)
+        free(svec->segments[i]);
+
+    free(svec);
+}
+
+short mc_svector_push(svector svec, long value) {
+    if (!svec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    size_t offset;
+    const size_t segment = svec_locate(svec->count, &offset);
+
+    if (segment >= svec->nsegments) {
+        if (svec->count >= SIZE_MAX / sizeof (long) - MC_SVECTOR_SEGMENT) {
+            errno = ENOMEM;
+            return 0;
+        }
+
+        if (!svec_reserve(svec, svec->count + 1)) {
+            errno = ENOBUFS;
+            return 0;
+        }
+    }
+
+    svec->segments[segment][offset] = value;
+    svec->count++;
+
+    return 1;
+}
+
+short mc_svector_append(svector svec, const long *src, size_t length) {
+    if (!svec || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (length == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (length > SIZE_MAX / sizeof (long) - MC_SVECTOR_SEGMENT - svec->count) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    // every segment is allocated first, so that nothing is appended if one of them cannot be
+    if (!svec_reserve(svec, svec->count + length)) {
+        errno = ENOBUFS;
+        return 0;
+    }
+
+    while (length > 0) {
+        size_t offset;
+        const size_t segment = svec_locate(svec->count, &offset);
+        const size_t n = (svec_segment_size(segment) - offset < length) ? svec_segment_size(segment) - offset : length;
+
+        memcpy(svec->segments[segment] + offset, src, n * sizeof (long));
+
+        svec->count += n;
+        src += n;
+        length -= n;
+    }
+
+    return 1;
+}
+
+short mc_svector_get(svector svec, size_t index, long *out) {
+    if (!out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    const long *elem = mc_svector_at(svec, index);
+
+    if (!elem)
+        return 0;
+
+    *out = *elem;
+    return 1;
+}
+
+short mc_svector_set(svector svec, size_t index, long value) {
+    long *elem = mc_svector_at(svec, index);
+
+    if (!elem)
+        return 0;
+
+    *elem = value;
+    return 1;
+}
+
+long *mc_svector_at(svector svec, size_t index) {
+    if (!svec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    if (index >= svec->count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t offset;
+    const size_t segment = svec_locate(index, &offset);
+
+    return svec->segments[segment] + offset;
+}
+
+size_t mc_svector_size(svector svec) {
+    if (!svec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return svec->count;
+}
+
+vector_span mc_svector_span(svector svec, size_t index) {
+    vector_span res = { NULL, 0 };
+
+    if (!svec) {
+        errno = EFAULT;
+        return res;
+    }
+
+    if (index >= svec->count) {
+        errno = EINVAL;
+        return res;
+    }
+
+    size_t offset;
+    const size_t segment = svec_locate(index, &offset);
+    const size_t left = svec->count - index;
+
+    res.data = svec->segments[segment] + offset;
+    res.length = (svec_segment_size(segment) - offset < left) ? svec_segment_size(segment) - offset : left;
+
+    return res;
+}
+
+vector mc_svector_to_vector(svector svec) {
+    if (!svec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    vector res = mc_vector_make((svec->count > 0) ? svec->count : 1);
+
+    if (!res)
+        return NULL;
+
+    for (size_t index = 0, segment = 0; index < svec->count; segment++) {
+        const size_t n = (svec->count - index < svec_segment_size(segment))
+                       ? svec->count - index
+                       : svec_segment_size(segment);
+
+        if (!mc_vector_append(res, svec->segments[segment], n)) {
+            mc_vector_free(res);
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        index += n;
+    }
+
+    return res;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file   svector.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  A segmented vector of longs, for append-only workloads which grow very big (logs, streams of records).
+ *
+ *         Elements are stored on a directory of segments which are never moved nor reallocated: segment k holds
+ *         (MC_SVECTOR_SEGMENT << k) elements, and the first one is stored inside the vector itself (like the stack
+ *         buffer of 'vector.h'). Appending never copies existing elements, so the memory peak stays close to the size
+ *         of the content (instead of up to 3 times the content when a buffer is doubled), and a pointer to an element
+ *         stays valid for the whole life of the vector.
+ *
+ *         Indexed access is O(1) (the segment of an element is found from the position of its highest bit). To scan
+ *         the vector, 'mc_svector_span' gives the contiguous run of elements starting at an index, so that every
+ *         segment can be handed at once to a kernel working on plain arrays.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_SVECTOR_H
+#define MC_SVECTOR_H
+
+#include <stddef.h>
+
+#include "vector.h"
+
+// The number of elements of the first segment (stored inside the vector), must be a power of two
+#ifndef MC_SVECTOR_SEGMENT
+#   define MC_SVECTOR_SEGMENT 16
+#endif
+
+
+#ifndef MC_VECTOR_NO_MACROS
+
+#define svmake(capacity)                    mc_svector_make(capacity)
+#define svfree(svec)                        mc_svector_free(svec)
+
+#define svpush(svec, value)                 mc_svector_push(svec, value)
+#define svappend(svec, src, len)            mc_svector_append(svec, src, len)
+
+#define svget(svec, index, out)             mc_svector_get(svec, index, out)
+#define svset(svec, index, value)           mc_svector_set(svec, index, value)
+#define svat(svec, index)                   mc_svector_at(svec, index)
+#define svsize(svec)                        mc_svector_size(svec)
+#define svspan(svec, index)                 mc_svector_span(svec, index)
+#define svtovec(svec)                       mc_svector_to_vector(svec)
+
+#endif /* MC_VECTOR_NO_MACROS */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declaration of the segmented vector struct
+typedef struct svector_s * svector;
+
+
+
+
+
+/**
+ * @brief Creates a new segmented vector. The segments needed to hold 'capacity' elements are allocated upfront, so
+ *        that appends below this capacity never allocate.
+ *
+ * @param[in] capacity  The number of elements to allocate room for (may be 0, the first segment is always there)
+ *
+ * @return A pointer to a new segmented vector if operation succeeded, NULL otherwise
+ *
+ * @note   If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+svector mc_svector_make(size_t capacity);
+
+/**
+ * @brief Destroys the segmented vector. Note that if given pointer is NULL, this function has no effect
+ *
+ * @param[inout] svec  The segmented vector to be destroyed
+ */
+void mc_svector_free(svector svec);
+
+/**
+ * @brief Appends an element at the end of the segmented vector. Existing elements are never moved.
+ *
+ * @param[inout] svec   The segmented vector
+ * @param[in]    value  The element to be added
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If the vector is full (i.e. its size would overflow), [errno] will be set to @c ENOMEM
+ *         If a segment cannot be allocated, [errno] will be set to @c ENOBUFS
+ */
+short mc_svector_push(svector svec, long value);
+
+/**
+ * @brief Appends several elements at the end of the segmented vector. Existing elements are never moved.
+ *
+ * @param[inout] svec    The segmented vector
+ * @param[in]    src     The elements to be added
+ * @param[in]    length  The number of elements to be added
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector or src is NULL, [errno] will be set to @c EFAULT
+ *         If length is invalid (i.e. length == 0), [errno] will be set to @c EINVAL
+ *         If the vector is full (i.e. its size would overflow), [errno] will be set to @c ENOMEM
+ *         If a segment cannot be allocated, [errno] will be set to @c ENOBUFS, and nothing is appended
+ */
+short mc_svector_append(svector svec, const long *src, size_t length);
+
+/**
+ * @brief Gets an element from the segmented vector
+ *
+ * @param[in]  svec   The segmented vector
+ * @param[in]  index  The position of the element
+ * @param[out] out    Where the element is stored
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector or out is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ */
+short mc_svector_get(svector svec, size_t index, long *out);
+
+/**
+ * @brief Sets the value of an element on the segmented vector
+ *
+ * @param[inout] svec   The segmented vector
+ * @param[in]    index  The position of the element
+ * @param[in]    value  The new value of the element
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ */
+short mc_svector_set(svector svec, size_t index, long value);
+
+/**
+ * @brief Gives a pointer to an element, which stays valid until the vector is destroyed (appends never move it)
+ *
+ * @param[in] svec   The segmented vector
+ * @param[in] index  The position of the element
+ *
+ * @return A pointer to the element, NULL if operation failed
+ *
+ * @note   Only the elements of the same segment follow each other in memory (see 'mc_svector_span').
+ *         If vector is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ */
+long *mc_svector_at(svector svec, size_t index);
+
+/**
+ * @brief Gets the number of elements of the segmented vector
+ *
+ * @param[in] svec  The segmented vector
+ *
+ * @return The number of elements
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_svector_size(svector svec);
+
+/**
+ * @brief Gives the contiguous run of elements starting at given index, up to the end of its segment (or of the
+ *        vector). Walking the whole vector is done span by span:
+ *
+ *        for (size_t i = 0; i < mc_svector_size(svec); i += span.length) { span = mc_svector_span(svec, i); ... }
+ *
+ * @param[in] svec   The segmented vector
+ * @param[in] index  The position of the first element of the span
+ *
+ * @return A read-only span over the elements, {NULL, 0} if operation failed
+ *
+ * @note   The span stays valid until the vector is destroyed.
+ *         If vector is NULL, [errno] will be set to @c EFAULT
+ *         If index is invalid (i.e. index >= size), [errno] will be set to @c EINVAL
+ */
+vector_span mc_svector_span(svector svec, size_t index);
+
+/**
+ * @brief Copies the elements into a new (regular) vector
+ *
+ * @param[in] svec  The segmented vector
+ *
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_svector_to_vector(svector svec);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Header Guard */
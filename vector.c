@@ -5,21 +5,21 @@
  * 
  * @brief  A small library for manipulating dynamically allocated arrays (vector).
  *         Vector are constructed using small buffer optimization. An initial buffer is allocated on the stack, its size is defined
- *         by the macro 'MC_VECTOR_BUFSIZE'. If we need more memory than we got on the stack, then a new buffer will be allocated
- *         on the heap. This means that the vector's capacity can be increased or decreased at runtime. Note however than a vector
- *         capacity cannot be smaller than 'MC_VECTOR_BUFSIZE', since we will go back to the stack buffer if capacity is decreased
- *         such that it can fit on the stack.
+ *         by the macro 'MC_VECTOR_BUFSIZE' (or chosen per vector, see 'mc_vector_make_sbo'). If we need more memory than we got
+ *         on the stack, then a new buffer will be allocated on the heap. This means that the vector's capacity can be increased
+ *         or decreased at runtime. Note however than a vector capacity cannot be smaller than its stack buffer size, since we
+ *         will go back to the stack buffer if capacity is decreased such that it can fit on the stack.
  *         Memory management is handled automatically by the API, but some functions can be used to manually increase or decrease
  *         the vector's capacity (such as 'resize' or 'shrink').
  *         The vector type is a typedef for a pointer to an opaque struct. This means user cannot access the content of the vector
- *         without using API's function, and that vector are passed by reference by default (this behavior can however be bypassed
- *         by using 'struct vector_s' instead of 'vector', but it is not recommended).  
+ *         without using API's function, and that vector are passed by reference by default. Since the stack buffer is stored at
+ *         the end of the struct and sized at creation, 'struct vector_s' cannot be used by value.  
  *         The api provides several function to create and destroy a vector, and to manipulate its content (inserting / removing /
  *         accessing elements). 
  * 
  *         !!!!!!!!!!!!! NOTE THAT SINCE 'VECTOR' IS A POINTER, YOU [[HAVE TO]] DEALLOCATE THEM TO AVOID MEMORY LEAKS !!!!!!!!!!!!!      
  *    
- * @version 1.3
+ * @version 1.4
  * 
  * @date 2022-08-17
  * 
@@ -27,686 +27,4154 @@
  * 
  */
 
+// mremap is a GNU extension
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 #include <errno.h>
 
+#define MC_VECTOR_IMPLEMENTATION
 #include "vector.h"
 
 
-#if !defined(MC_VECTOR_NO_IO) && defined(_WIN32)
-#   define fprintf(...)     fprintf_s(__VA_ARGS__)
-#   define sprintf(...)     sprintf_s(__VA_ARGS__)
-#elif !defined(MC_VECTOR_NO_IO)
-#   define sprintf(buf, size, ...) sprintf(buf, __VA_ARGS__)
-#endif 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <immintrin.h>
+#   define VEC_X86
+#   define VEC_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#   include <arm_neon.h>
+#   define VEC_NEON
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   define VEC_MMAP
+#   if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#       define MAP_ANONYMOUS MAP_ANON
+#   endif
+#endif
 
-#if defined(__GNUC__) 
-#   pragma GCC diagnostic ignored "-Wformat-extra-args"
-#endif 
+// Fills smaller than this (in bytes) never use non-temporal stores, whatever the cache size
+#ifndef MC_VECTOR_NT_MIN
+#   define MC_VECTOR_NT_MIN (1 << 20)
+#endif
 
-#ifndef MC_VECTOR_NO_IO
-#   include <wchar.h>
+// The last level cache size (in bytes), used when it cannot be queried at runtime
+#ifndef MC_VECTOR_LLC_SIZE
+#   define MC_VECTOR_LLC_SIZE (8 << 20)
 #endif
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 
+// The alignment required by a vector and by its elements
+#define VEC_ALIGN offsetof(struct { char c; union { size_t s; long *p; long l; } x; }, x)
 
 
-struct vector_s {
-    size_t count;                           // The number of element currently stored on the vector
-    size_t capacity;                        // The total capacity of the vector
 
-    long  stack_buf[MC_VECTOR_BUFSIZE];     // A buffer allocated on the stack
-    long *heap_buf;                         // A pointer to a buffer allocated on the heap, if needed
+// Every allocation goes through these helpers: a NULL allocator means the standard malloc / realloc / free
+static void *vec_alloc(const mc_allocator *allocator, size_t size) {
+    if (!allocator)
+        return malloc(size);
 
-    long  *data;                            // A pointer to the currently used buffer (stack_buf or heap_buf)
-};
+    return allocator->alloc(allocator->ctx, size, VEC_ALIGN);
+}
 
+static void *vec_realloc(const mc_allocator *allocator, void *ptr, size_t oldSize, size_t newSize) {
+    if (!allocator)
+        return realloc(ptr, newSize);
 
+    return allocator->realloc(allocator->ctx, ptr, oldSize, newSize, VEC_ALIGN);
+}
 
-vector mc_vector_make(size_t capacity) {
-    if (capacity == 0) {
-        errno = EINVAL;
-        return NULL;
+static void vec_free(const mc_allocator *allocator, void *ptr, size_t size) {
+    if (!allocator) {
+        free(ptr);
+        return;
     }
 
-    vector res = (vector)(malloc(sizeof (struct vector_s)));
+    if (ptr)
+        allocator->free(allocator->ctx, ptr, size);
+}
 
-    if (!res) {
-        errno = ENOBUFS;
-        return NULL;
-    }
+// Instrumentation (MC_VECTOR_STATS). Every counter is kept twice: on the vector, and summed for the whole library.
+// Library counters are updated with relaxed atomics where the compiler has them, vectors are not shared between threads
 
-    if (capacity > MC_VECTOR_BUFSIZE) {
-        res->heap_buf = (long*)(malloc(capacity * sizeof (long)));
+#ifdef MC_VECTOR_STATS
 
-        if (!res->heap_buf) {
-            free(res);
-            errno = ENOBUFS;
-            return NULL;
-        }
+static vector_stats vec_stats;
 
-        res->data = res->heap_buf;
-        res->capacity = capacity;
+static void vec_stats_add(size_t *counter, size_t n) {
+#if defined(__GNUC__)
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+#else
+    *counter += n;
+#endif
+}
+
+static void vec_stats_sub(size_t *counter, size_t n) {
+#if defined(__GNUC__)
+    __atomic_fetch_sub(counter, n, __ATOMIC_RELAXED);
+#else
+    *counter -= n;
+#endif
+}
+
+static void vec_stats_max(size_t *counter, size_t value) {
+#if defined(__GNUC__)
+    size_t current = __atomic_load_n(counter, __ATOMIC_RELAXED);
+
+    while (value > current
+           && !__atomic_compare_exchange_n(counter, &current, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+#else
+    if (value > *counter)
+        *counter = value;
+#endif
+}
+
+static void vec_stats_peak(vector vec) {
+    if (vec->capacity > vec->stats.peak_capacity) {
+        vec->stats.peak_capacity = vec->capacity;
+        vec_stats_max(&vec_stats.peak_capacity, vec->capacity);
     }
-    else {
-        res->data = res->stack_buf;
-        res->heap_buf = NULL;
-        res->capacity = MC_VECTOR_BUFSIZE;
+
+    if (vec->count > vec->stats.peak_count) {
+        vec->stats.peak_count = vec->count;
+        vec_stats_max(&vec_stats.peak_count, vec->count);
     }
+}
 
-    res->count = 0;
+#   define VEC_STAT(vec, counter, n) \
+        ((vec)->stats.counter += (size_t)(n), vec_stats_add(&vec_stats.counter, (size_t)(n)))
+#   define VEC_STAT_PEAK(vec)       vec_stats_peak(vec)
+#   define VEC_STAT_HEAP_ADD(size)  vec_stats_add(&vec_stats.live_heap_bytes, size)
+#   define VEC_STAT_HEAP_SUB(size)  vec_stats_sub(&vec_stats.live_heap_bytes, size)
+#else
+#   define VEC_STAT(vec, counter, n) ((void)0)
+#   define VEC_STAT_PEAK(vec)       ((void)0)
+#   define VEC_STAT_HEAP_ADD(size)  ((void)0)
+#   define VEC_STAT_HEAP_SUB(size)  ((void)0)
+#endif /* MC_VECTOR_STATS */
+
+static unsigned char vec_log2(size_t x) {
+    unsigned char res = 0;
+
+    while (x >>= 1)
+        res++;
 
     return res;
 }
 
-vector mc_vector_make_filled(size_t capacity, size_t length, long value) {
-    if (capacity == 0 || length == 0 || capacity < length) {
-        errno = EINVAL;
-        return NULL;
+// Allocation cache (MC_VECTOR_CACHE). Every thread keeps a list of free headers (of vectors using the standard
+// allocator and the default stack buffer size), and lists of free heap buffers by size class (log2 of their size).
+// Cached blocks are linked through their first bytes. Thread-local storage is required, otherwise there is no cache
+
+#ifdef MC_VECTOR_CACHE
+#   if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#       define VEC_TLS _Thread_local
+#   elif defined(__GNUC__)
+#       define VEC_TLS __thread
+#   elif defined(_MSC_VER)
+#       define VEC_TLS __declspec(thread)
+#   endif
+
+#   ifdef VEC_TLS
+#       define VEC_CACHE
+#   endif
+#endif
+
+#ifdef VEC_CACHE
+
+#define VEC_CACHE_MIN_CLASS 6                   // buffers smaller than 64 bytes are not kept
+#define VEC_CACHE_CLASSES (sizeof (size_t) * CHAR_BIT)
+
+typedef struct vec_cached_s {
+    struct vec_cached_s *next;
+    size_t size;                                // The size of the buffer, in bytes
+    unsigned char align;                        // The alignment of the buffer, as a power of two (log2)
+} vec_cached;
+
+static VEC_TLS struct {
+    void       *headers;                        // The free headers, linked through their first pointer
+    size_t      nheaders;
+    vec_cached *buffers[VEC_CACHE_CLASSES];     // The free heap buffers, by size class
+    size_t      nbuffers[VEC_CACHE_CLASSES];
+    vector_cache_stats stats;
+} vec_cache;
+
+#define vec_header_is_cached(allocator, size) \
+    (!(allocator) && (size) == sizeof (struct vector_s) + MC_VECTOR_BUFSIZE * sizeof (long))
+
+#define vec_buf_is_cached(size) \
+    ((size) >= ((size_t)(1) << VEC_CACHE_MIN_CLASS) && (size) <= MC_VECTOR_CACHE_MAX_BUFFER)
+
+// Takes a cached buffer of at least 'size' bytes and 'align' alignment, NULL if there is none
+static void *vec_cache_take(size_t size, unsigned char align) {
+    const unsigned char cls = vec_log2(size);
+
+    for (vec_cached **it = &vec_cache.buffers[cls]; *it; it = &(*it)->next) {
+        vec_cached *res = *it;
+
+        if (res->size >= size && res->align >= align) {
+            *it = res->next;
+            vec_cache.nbuffers[cls]--;
+            vec_cache.stats.buffer_hits++;
+            return res;
+        }
     }
 
-    vector res = mc_vector_make(capacity);
+    vec_cache.stats.buffer_misses++;
+    return NULL;
+}
 
-    if (!res)
-        return NULL;
+// Keeps a buffer in the cache, returns 0 if its size class is full
+static short vec_cache_put(void *ptr, size_t size, unsigned char align) {
+    const unsigned char cls = vec_log2(size);
 
-    
-    // cannot use memset here since we use long :(
-    for (size_t i = 0; i < length; i++) {
-        res->data[i] = value;
+    if (vec_cache.nbuffers[cls] >= MC_VECTOR_CACHE_BUFFERS)
+        return 0;
+
+    vec_cached *entry = (vec_cached*)(ptr);
+
+    entry->next = vec_cache.buffers[cls];
+    entry->size = size;
+    entry->align = align;
+
+    vec_cache.buffers[cls] = entry;
+    vec_cache.nbuffers[cls]++;
+    return 1;
+}
+
+#endif /* VEC_CACHE */
+
+// Vector headers go through these helpers, so that they can be served by the cache
+static void *vec_header_alloc(const mc_allocator *allocator, size_t size) {
+#ifdef VEC_CACHE
+    if (vec_header_is_cached(allocator, size)) {
+        void *res = vec_cache.headers;
+
+        if (res) {
+            vec_cache.headers = *(void**)(res);
+            vec_cache.nheaders--;
+            vec_cache.stats.header_hits++;
+            return res;
+        }
+
+        vec_cache.stats.header_misses++;
     }
+#endif
 
-    res->count = length;
-    return res;
+    return vec_alloc(allocator, size);
 }
 
-vector mc_vector_clone(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return NULL;
+static void vec_header_free(const mc_allocator *allocator, void *ptr, size_t size) {
+#ifdef VEC_CACHE
+    if (ptr && vec_header_is_cached(allocator, size) && vec_cache.nheaders < MC_VECTOR_CACHE_HEADERS) {
+        *(void**)(ptr) = vec_cache.headers;
+        vec_cache.headers = ptr;
+        vec_cache.nheaders++;
+        return;
     }
+#endif
 
-    vector res = mc_vector_make(vec->capacity);
+    vec_free(allocator, ptr, size);
+}
 
-    if (!res)
-        return NULL;
+// Large vectors. Their buffers are anonymous mappings, which can be grown by the system without copying (mremap) and
+// whose pages can be given back without unmapping them (MADV_DONTNEED). Transparent huge pages are asked with
+// MADV_HUGEPAGE, to reduce TLB misses when scanning
 
-    memcpy(res->data, vec->data, vec->count * sizeof (long));
+// Flags of a vector (vec->flags)
+#define VEC_BUF_ADOPTED 0x01                // heap_buf was given by the caller (see 'mc_vector_adopt')
+#define VEC_BUF_SHARED  0x02                // data is a buffer shared with other vectors, held by map (see below)
 
-    res->capacity = vec->capacity;
-    res->count = vec->count;
+#ifdef VEC_MMAP
 
-    return res;
+#define vec_is_mapped(vec, size) (!(vec)->allocator && (size) >= MC_VECTOR_MMAP_THRESHOLD)
+
+static size_t vec_page_size(void) {
+    const long res = sysconf(_SC_PAGESIZE);
+    return (res > 0) ? (size_t)(res) : MC_VECTOR_PAGESIZE;
 }
 
-vector mc_vector_from_array(long *src, size_t length) {
-    if (!src) {
-        errno = EFAULT;
-        return NULL;
-    }
+static size_t vec_page_round(size_t size) {
+    const size_t page = vec_page_size();
+    return (size + page - 1) & ~(page - 1);
+}
 
-    if (length == 0) {
-        errno = EINVAL;
+static void *vec_map_alloc(size_t size, size_t align) {
+    const size_t page = vec_page_size();
+    const size_t extra = (align > page) ? align : 0;
+
+    if (size > SIZE_MAX - page - extra)
         return NULL;
+
+    size = vec_page_round(size);
+    unsigned char *res = NULL;
+
+#if defined(MC_VECTOR_HUGETLB) && defined(MAP_HUGETLB)
+    if (extra == 0 && size % MC_VECTOR_MAX_ALIGNMENT == 0) {
+        res = (unsigned char*)(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0));
+        res = (res == MAP_FAILED) ? NULL : res;
     }
+#endif
+
+    if (!res) {
+        res = (unsigned char*)(mmap(NULL, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
 
+        if (res == MAP_FAILED)
+            return NULL;
 
-    vector res = mc_vector_make(length * 2);
+        if (extra) {
+            // alignment bigger than a page: map more than needed, and unmap what is around the aligned buffer
+            unsigned char *aligned = (unsigned char*)(((uintptr_t)(res) + align - 1) & ~(uintptr_t)(align - 1));
+            const size_t head = (size_t)(aligned - res);
 
-    if (!res)
-        return NULL;
+            if (head)
+                munmap(res, head);
 
-    memcpy(res->data, src, length * sizeof (long));
+            if (extra - head)
+                munmap(aligned + size, extra - head);
 
-    res->capacity = length * 2;
-    res->count = length;
+            res = aligned;
+        }
+
+#ifdef MADV_HUGEPAGE
+        madvise(res, size, MADV_HUGEPAGE);
+#endif
+    }
 
     return res;
 }
 
-void mc_vector_free(vector vec) {
-    if (!vec)
-        return;
-
-    if (vec->heap_buf) 
-        free(vec->heap_buf);
+static void vec_map_free(void *ptr, size_t size) {
+    munmap(ptr, vec_page_round(size));
+}
 
-    free(vec);
+// Gives the pages of [ptr + from, ptr + size) back to the system, the mapping stays valid (and reads as zeros)
+static void vec_map_release(void *ptr, size_t from, size_t size) {
+#ifdef MADV_DONTNEED
+    const size_t start = vec_page_round(from);
+    const size_t end = vec_page_round(size);
+
+    if (start < end)
+        madvise((unsigned char*)(ptr) + start, end - start, MADV_DONTNEED);
+#else
+    (void)ptr;
+    (void)from;
+    (void)size;
+#endif
 }
 
+#else
+#   define vec_is_mapped(vec, size) 0
+#endif /* VEC_MMAP */
 
-int mc_vector_to_array(vector vec, long *buffer) {
-    return mc_vector_extract(vec, buffer, 0, vec->count);
-}
 
-int mc_vector_extract(vector vec, long *buffer, size_t index, size_t length) {
-    if (!vec || !buffer) {
-        errno = EFAULT;
-        return 0;
-    }
 
-    if (index >= vec->count || length == 0 || index + length > vec->count) {
-        errno = EINVAL;
-        return 0;
-    }
+// Heap buffers are allocated through these helpers, with the alignment of the vector. Buffers of the standard
+// allocator come from posix_memalign where it exists (so that they can be given away to code using free, see
+// 'mc_vector_release'), otherwise they are over-allocated from malloc, the pointer to be freed being stored right
+// before the aligned buffer. Since no realloc can keep the alignment, growing allocates a new buffer and copies the
+// elements into it.
+// A buffer adopted from the caller (VEC_BUF_ADOPTED) is released with free, and replaced by one of ours on growth
 
-    for (size_t i = index, pos = 0; i < index + length; i++, pos++) {
-        buffer[pos] = vec->data[i];
-    }
+#ifdef VEC_MMAP
+#   define VEC_MEMALIGN
+#endif
 
-    return (int)length;
+// Frees a buffer of the standard allocator
+static void vec_buf_free_std(void *ptr) {
+#ifdef VEC_MEMALIGN
+    free(ptr);
+#else
+    free(((void**)(ptr))[-1]);
+#endif
 }
 
+static void *vec_buf_new(vector vec, size_t size, short zero) {
+    const size_t align = (size_t)(1) << vec->align;
 
+#ifdef VEC_MMAP
+    // mappings are always zeroed
+    if (vec_is_mapped(vec, size))
+        return vec_map_alloc(size, align);
+#endif
 
+    if (vec->allocator) {
+        void *res = vec->allocator->alloc(vec->allocator->ctx, size, align);
 
-short mc_vector_get(vector vec, size_t index, long *out) {
-    if (!vec || !out) {
-        errno = EFAULT;
-        return 0;
-    }
+        if (res && zero)
+            memset(res, 0, size);
 
-    if (index >= vec->capacity) {
-        errno = EINVAL;
-        return 0;
+        return res;
     }
 
-    *out = vec->data[index];
-    return 1;
-}
+#ifdef VEC_CACHE
+    if (vec_buf_is_cached(size)) {
+        void *res = vec_cache_take(size, vec->align);
 
-long mc_vector_get_unchecked(vector vec, size_t index) {
-    if (!vec || index >= vec->capacity) {
-        return LONG_MAX;
+        if (res) {
+            if (zero)
+                memset(res, 0, size);
+
+            return res;
+        }
     }
+#endif
 
-    return vec->data[index];
+#ifdef VEC_MEMALIGN
+    void *res = NULL;
+
+    if (posix_memalign(&res, align, size ? size : 1) != 0)
+        return NULL;
+
+    if (zero)
+        memset(res, 0, size);
+
+    return res;
+#else
+    if (size > SIZE_MAX - align - sizeof (void*))
+        return NULL;
+
+    const size_t total = size + align + sizeof (void*);
+    unsigned char *raw = (unsigned char*)(zero ? calloc(1, total) : malloc(total));
+
+    if (!raw)
+        return NULL;
+
+    const uintptr_t res = ((uintptr_t)(raw + sizeof (void*)) + align - 1) & ~(uintptr_t)(align - 1);
+
+    ((void**)(res))[-1] = raw;
+    return (void*)(res);
+#endif
 }
 
-short mc_vector_set(vector vec, size_t index, long value) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
-    }
+static void *vec_buf_alloc(vector vec, size_t size, short zero) {
+    void *res = vec_buf_new(vec, size, zero);
 
-    if (index >= vec->count) {
-        errno = EINVAL;
-        return 0;
-    }
+    if (res)
+        VEC_STAT_HEAP_ADD(size);
 
-    vec->data[index] = value;
-    return 1;
+    return res;
 }
 
+static void vec_buf_free(vector vec, void *ptr, size_t size) {
+    if (!ptr)
+        return;
 
+    VEC_STAT_HEAP_SUB(size);
 
-size_t mc_vector_size(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+    if (vec->flags & VEC_BUF_ADOPTED) {
+        vec->flags &= (unsigned char)(~VEC_BUF_ADOPTED);
+        free(ptr);
+        return;
     }
 
-    return vec->count;
-}
+#ifdef VEC_MMAP
+    if (vec_is_mapped(vec, size)) {
+        vec_map_free(ptr, size);
+        return;
+    }
+#endif
 
-size_t mc_vector_capacity(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+    if (vec->allocator) {
+        vec->allocator->free(vec->allocator->ctx, ptr, size);
+        return;
     }
 
-    return vec->capacity;
+#ifdef VEC_CACHE
+    if (vec_buf_is_cached(size) && vec_cache_put(ptr, size, vec->align))
+        return;
+#endif
+
+    vec_buf_free_std(ptr);
 }
 
-short mc_vector_empty(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return 1;
+// Moves the heap buffer (ptr may be NULL) to a buffer of newSize bytes, only the elements of the vector are kept
+static void *vec_buf_realloc(vector vec, void *ptr, size_t oldSize, size_t newSize) {
+    if (vec->allocator) {
+        void *res = vec->allocator->realloc(vec->allocator->ctx, ptr, oldSize, newSize, (size_t)(1) << vec->align);
+
+        if (res) {
+            VEC_STAT_HEAP_SUB(ptr ? oldSize : 0);
+            VEC_STAT_HEAP_ADD(newSize);
+        }
+
+        return res;
     }
 
-    return vec->count == 0;
-}
+#if defined(VEC_MMAP) && defined(MREMAP_MAYMOVE)
+    if (ptr && !(vec->flags & VEC_BUF_ADOPTED) && vec_is_mapped(vec, oldSize) && vec_is_mapped(vec, newSize)
+        && ((size_t)(1) << vec->align) <= vec_page_size()) {
+        // let the system move the pages, nothing is copied
+        void *res = mremap(ptr, vec_page_round(oldSize), vec_page_round(newSize), MREMAP_MAYMOVE);
 
-short mc_vector_is_stack(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+        if (res != MAP_FAILED) {
+            VEC_STAT_HEAP_SUB(oldSize);
+            VEC_STAT_HEAP_ADD(newSize);
+            return res;
+        }
+    }
+#endif
+
+    void *res = vec_buf_alloc(vec, newSize, 0);
+
+    if (res && ptr) {
+        memcpy(res, ptr, min(vec->count * sizeof (long), newSize));
+        vec_buf_free(vec, ptr, oldSize);
     }
 
-    return vec->data != vec->heap_buf;
+    return res;
 }
 
+// Whether the heap buffer can be handed to code using free
+static short vec_buf_is_malloc(vector vec) {
+    if (vec->data != vec->heap_buf)
+        return 0;
 
+    if (vec->flags & VEC_BUF_ADOPTED)
+        return 1;
 
+#ifdef VEC_MEMALIGN
+    return !vec->allocator && !vec_is_mapped(vec, vec->capacity * sizeof (long));
+#else
+    return 0;
+#endif
+}
 
+// Shared buffers (see 'mc_vector_share'). The vectors sharing a heap buffer all point to the same reference counted
+// descriptor through their 'map' field, heap_buf being NULL: like a file mapping, the buffer is not theirs, so that
+// growing copies the elements and releases it. Functions modifying elements in place call 'vec_writable' first.
+// The last vector releasing the buffer frees it, as the vector which allocated it would have
+
+typedef struct {
+    size_t refs;                            // The number of vectors using the buffer
+    long  *buf;                             // The buffer, allocated as the heap buffer of the first vector
+    size_t size;                            // The size of the buffer, in bytes
+    unsigned char align;                    // The alignment of the buffer (log2)
+    unsigned char flags;                    // How the buffer was obtained (adopted from the caller or not)
+} vec_shared;
+
+// Vectors sharing a buffer may be used by different threads, so the count is atomic where the compiler allows it
+static void vec_refs_acquire(size_t *refs) {
+#if defined(__GNUC__)
+    __atomic_fetch_add(refs, 1, __ATOMIC_RELAXED);
+#else
+    ++*refs;
+#endif
+}
 
- short vec_ensure_capacity(vector vec, size_t len) {
-    if (!vec)
-        return 0;
+static size_t vec_refs_release(size_t *refs) {
+#if defined(__GNUC__)
+    return __atomic_sub_fetch(refs, 1, __ATOMIC_ACQ_REL);
+#else
+    return --*refs;
+#endif
+}
 
-    if (vec->count + len >= vec->capacity) {
-        // need realloc
-        const size_t cap = (vec->capacity * 2) + len;
+static size_t vec_refs_load(size_t *refs) {
+#if defined(__GNUC__)
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE);
+#else
+    return *refs;
+#endif
+}
 
-        long *temp = realloc(vec->heap_buf, cap * sizeof (long));
+// Stops using the shared buffer, the elements must have been moved somewhere else
+static void vec_share_drop(vector vec) {
+    vec_shared *shared = (vec_shared*)(vec->map);
 
-        if (!temp)
-            return 0;
+    if (vec_refs_release(&shared->refs) == 0) {
+        const unsigned char align = vec->align;
 
-        if (vec->heap_buf == NULL) {
-            memcpy(temp, vec->stack_buf, vec->capacity * sizeof (long));
-        }
+        vec->align = shared->align;
+        vec->flags = shared->flags;
+        vec_buf_free(vec, shared->buf, shared->size);
+        vec->align = align;
 
-        vec->heap_buf = temp;
-        vec->data = vec->heap_buf;
-        vec->capacity = cap;
+        vec_free(vec->allocator, shared, sizeof (vec_shared));
     }
 
-    return 1;
+    vec->flags = 0;
+    vec->map = NULL;
+    vec->mapsize = 0;
 }
 
+// Gives a vector sharing its buffer its own elements: the buffer itself if no other vector uses it anymore, a copy
+// otherwise
+static short vec_unshare(vector vec) {
+    vec_shared *shared = (vec_shared*)(vec->map);
 
-short mc_vector_push(vector vec, long value) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+    if (vec_refs_load(&shared->refs) == 1 && shared->align == vec->align) {
+        // nobody else can get the buffer back, it is ours again
+        vec->heap_buf = shared->buf;
+        vec->data = shared->buf;
+        vec->flags = shared->flags;
+        vec->map = NULL;
+        vec->mapsize = 0;
+
+        vec_free(vec->allocator, shared, sizeof (vec_shared));
+        return 1;
     }
 
-    if (!vec_ensure_capacity(vec, 1)) {
-        errno = ENOMEM;
+    long *temp = (long*)(vec_buf_alloc(vec, vec->capacity * sizeof (long), 0));
+
+    if (!temp)
         return 0;
-    }
 
-    vec->data[vec->count++] = value;
+    memcpy(temp, vec->data, vec->count * sizeof (long));
+    vec_share_drop(vec);
+
+    vec->heap_buf = temp;
+    vec->data = temp;
+
+    VEC_STAT(vec, reallocations, 1);
     return 1;
 }
 
-long mc_vector_pop(vector vec) {
+// Whether the elements can be modified in place, after being copied if they are shared
+#define vec_writable(vec) (!((vec)->flags & VEC_BUF_SHARED) || vec_unshare(vec))
+
+// Releases the file mapping of a vector created by 'mc_vector_mmap' (or its shared buffer), once its content has
+// moved somewhere else
+static void vec_unmap(vector vec) {
+    if (vec->flags & VEC_BUF_SHARED) {
+        vec_share_drop(vec);
+        return;
+    }
+
+#ifdef VEC_MMAP
+    if (vec->map)
+        munmap(vec->map, vec->mapsize);
+#endif
+
+    vec->map = NULL;
+    vec->mapsize = 0;
+}
+
+
+
+// Fill kernels. Every kernel fills 'length' elements, 'stream' asks for non-temporal stores (which bypass the cache)
+
+static void vec_fill_scalar(long *dst, size_t length, long value) {
+    for (size_t i = 0; i < length; i++) {
+        dst[i] = value;
+    }
+}
+
+#ifdef VEC_X86
+
+#if LONG_MAX > 2147483647L
+#   define vec_set1_128(x)  _mm_set1_epi64x(x)
+#   define vec_set1_256(x)  _mm256_set1_epi64x(x)
+#   define vec_set1_512(x)  _mm512_set1_epi64(x)
+#else
+#   define vec_set1_128(x)  _mm_set1_epi32(x)
+#   define vec_set1_256(x)  _mm256_set1_epi32(x)
+#   define vec_set1_512(x)  _mm512_set1_epi32(x)
+#endif
+
+// Number of scalar stores needed to reach an address aligned on 'align' bytes
+#define vec_head(ptr, align, length) \
+    min((length), ((align) - ((uintptr_t)(ptr) & ((align) - 1))) % (align) / sizeof (long))
+
+VEC_TARGET("sse2")
+static void vec_fill_sse2(long *dst, size_t length, long value, short stream) {
+    const size_t lanes = 16 / sizeof (long);
+    const __m128i v = vec_set1_128(value);
+    size_t i = vec_head(dst, 16, length);
+
+    vec_fill_scalar(dst, i, value);
+
+    if (stream) {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm_stream_si128((__m128i*)(dst + i), v);
+            _mm_stream_si128((__m128i*)(dst + i + lanes), v);
+            _mm_stream_si128((__m128i*)(dst + i + lanes * 2), v);
+            _mm_stream_si128((__m128i*)(dst + i + lanes * 3), v);
+        }
+        _mm_sfence();
+    }
+    else {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm_store_si128((__m128i*)(dst + i), v);
+            _mm_store_si128((__m128i*)(dst + i + lanes), v);
+            _mm_store_si128((__m128i*)(dst + i + lanes * 2), v);
+            _mm_store_si128((__m128i*)(dst + i + lanes * 3), v);
+        }
+    }
+
+    vec_fill_scalar(dst + i, length - i, value);
+}
+
+VEC_TARGET("avx2")
+static void vec_fill_avx2(long *dst, size_t length, long value, short stream) {
+    const size_t lanes = 32 / sizeof (long);
+    const __m256i v = vec_set1_256(value);
+    size_t i = vec_head(dst, 32, length);
+
+    vec_fill_scalar(dst, i, value);
+
+    if (stream) {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm256_stream_si256((__m256i*)(dst + i), v);
+            _mm256_stream_si256((__m256i*)(dst + i + lanes), v);
+            _mm256_stream_si256((__m256i*)(dst + i + lanes * 2), v);
+            _mm256_stream_si256((__m256i*)(dst + i + lanes * 3), v);
+        }
+        _mm_sfence();
+    }
+    else {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm256_store_si256((__m256i*)(dst + i), v);
+            _mm256_store_si256((__m256i*)(dst + i + lanes), v);
+            _mm256_store_si256((__m256i*)(dst + i + lanes * 2), v);
+            _mm256_store_si256((__m256i*)(dst + i + lanes * 3), v);
+        }
+    }
+
+    vec_fill_scalar(dst + i, length - i, value);
+}
+
+VEC_TARGET("avx512f")
+static void vec_fill_avx512(long *dst, size_t length, long value, short stream) {
+    const size_t lanes = 64 / sizeof (long);
+    const __m512i v = vec_set1_512(value);
+    size_t i = vec_head(dst, 64, length);
+
+    vec_fill_scalar(dst, i, value);
+
+    if (stream) {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm512_stream_si512((void*)(dst + i), v);
+            _mm512_stream_si512((void*)(dst + i + lanes), v);
+            _mm512_stream_si512((void*)(dst + i + lanes * 2), v);
+            _mm512_stream_si512((void*)(dst + i + lanes * 3), v);
+        }
+        _mm_sfence();
+    }
+    else {
+        for (; i + lanes * 4 <= length; i += lanes * 4) {
+            _mm512_store_si512((void*)(dst + i), v);
+            _mm512_store_si512((void*)(dst + i + lanes), v);
+            _mm512_store_si512((void*)(dst + i + lanes * 2), v);
+            _mm512_store_si512((void*)(dst + i + lanes * 3), v);
+        }
+    }
+
+    vec_fill_scalar(dst + i, length - i, value);
+}
+
+#endif /* VEC_X86 */
+
+#ifdef VEC_NEON
+
+static void vec_fill_neon(long *dst, size_t length, long value) {
+    const int64x2_t v = vdupq_n_s64(value);
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        vst1q_s64((int64_t*)(dst + i), v);
+        vst1q_s64((int64_t*)(dst + i + 2), v);
+        vst1q_s64((int64_t*)(dst + i + 4), v);
+        vst1q_s64((int64_t*)(dst + i + 6), v);
+    }
+
+    vec_fill_scalar(dst + i, length - i, value);
+}
+
+#endif /* VEC_NEON */
+
+// The size of the last level cache, in bytes
+static size_t vec_llc_size(void) {
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    const long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    if (size > 0)
+        return (size_t)(size);
+#endif
+
+    return MC_VECTOR_LLC_SIZE;
+}
+
+// Whether every byte of value is the same (in which case the fill is just a memset)
+static short vec_is_byte_pattern(long value) {
+    const unsigned long bytes = (unsigned long)(value) & 0xFF;
+    return (unsigned long)(value) == bytes * (ULONG_MAX / 0xFF);
+}
+
+static void vec_fill(long *dst, size_t length, long value) {
+    if (vec_is_byte_pattern(value)) {
+        memset(dst, (int)(value & 0xFF), length * sizeof (long));
+        return;
+    }
+
+    if (length < 16) {
+        vec_fill_scalar(dst, length, value);
+        return;
+    }
+
+#if defined(VEC_X86)
+    const size_t bytes = length * sizeof (long);
+    const short stream = bytes >= MC_VECTOR_NT_MIN && bytes > vec_llc_size();
+
+    if (__builtin_cpu_supports("avx512f"))
+        vec_fill_avx512(dst, length, value, stream);
+    else if (__builtin_cpu_supports("avx2"))
+        vec_fill_avx2(dst, length, value, stream);
+    else if (__builtin_cpu_supports("sse2"))
+        vec_fill_sse2(dst, length, value, stream);
+    else
+        vec_fill_scalar(dst, length, value);
+#elif defined(VEC_NEON)
+    vec_fill_neon(dst, length, value);
+#else
+    vec_fill_scalar(dst, length, value);
+#endif
+}
+
+
+
+vector mc_vector_make(size_t capacity) {
+    return mc_vector_make_sbo(capacity, MC_VECTOR_BUFSIZE);
+}
+
+vector mc_vector_make_sbo(size_t capacity, size_t bufsize) {
+    return mc_vector_make_with(capacity, bufsize, NULL);
+}
+
+vector mc_vector_make_with(size_t capacity, size_t bufsize, const mc_allocator *allocator) {
+    if (capacity == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (bufsize > (SIZE_MAX - sizeof (struct vector_s)) / sizeof (long)) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    const size_t size = sizeof (struct vector_s) + bufsize * sizeof (long);
+    vector res = (vector)(vec_header_alloc(allocator, size));
+
+    if (!res) {
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    res->bufsize = bufsize;
+    res->allocator = allocator;
+    res->growth = VGrowth_Double;
+    res->map = NULL;
+    res->mapsize = 0;
+    res->flags = 0;
+
+#ifdef MC_VECTOR_STATS
+    memset(&res->stats, 0, sizeof (vector_stats));
+#endif
+
+    // custom allocators get the natural alignment, unless a bigger one is asked with 'mc_vector_set_alignment'
+    res->align = vec_log2(allocator ? VEC_ALIGN : MC_VECTOR_ALIGNMENT);
+
+    if (capacity > bufsize) {
+        res->heap_buf = (capacity <= SIZE_MAX / sizeof (long))
+                      ? (long*)(vec_buf_alloc(res, capacity * sizeof (long), 0))
+                      : NULL;
+
+        if (!res->heap_buf) {
+            vec_header_free(allocator, res, size);
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        res->data = res->heap_buf;
+        res->capacity = capacity;
+    }
+    else {
+        res->data = res->stack_buf;
+        res->heap_buf = NULL;
+        res->capacity = bufsize;
+    }
+
+    res->count = 0;
+
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+vector mc_vector_make_block(size_t capacity) {
+    return mc_vector_make_sbo(capacity, capacity);
+}
+
+vector mc_vector_make_filled(size_t capacity, size_t length, long value) {
+    if (capacity == 0 || length == 0 || capacity < length) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (value == 0 && capacity > MC_VECTOR_BUFSIZE && capacity <= SIZE_MAX / sizeof (long)) {
+        // calloc can get already zeroed pages from the system, which is cheaper than filling them
+        vector res = mc_vector_make(MC_VECTOR_BUFSIZE);
+        long *buf = res ? (long*)(vec_buf_alloc(res, capacity * sizeof (long), 1)) : NULL;
+
+        if (!buf) {
+            mc_vector_free(res);
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        res->heap_buf = buf;
+        res->data = buf;
+        res->capacity = capacity;
+        res->count = length;
+
+        VEC_STAT_PEAK(res);
+        return res;
+    }
+
+    vector res = mc_vector_make(capacity);
+
+    if (!res)
+        return NULL;
+
+    vec_fill(res->data, length, value);
+
+    res->count = length;
+
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+vector mc_vector_clone(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    if (vec->flags & VEC_BUF_SHARED)
+        return mc_vector_share(vec);
+
+    // a vector mapped from an empty file has no capacity, while 'mc_vector_make_with' asks for some
+    vector res = mc_vector_make_with(vec->capacity ? vec->capacity : 1, vec->bufsize, vec->allocator);
+
+    if (!res)
+        return NULL;
+
+    res->growth = vec->growth;
+
+    if (res->align != vec->align && !mc_vector_set_alignment(res, (size_t)(1) << vec->align)) {
+        mc_vector_free(res);
+        errno = ENOBUFS;
+        return NULL;
+    }
+
+    memcpy(res->data, vec->data, vec->count * sizeof (long));
+
+    res->count = vec->count;
+
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+vector mc_vector_share(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    // inline elements and file mappings are copied
+    if (vec->data != vec->heap_buf && !(vec->flags & VEC_BUF_SHARED))
+        return mc_vector_clone(vec);
+
+    vector res = mc_vector_make_with(1, vec->bufsize, vec->allocator);
+
+    if (!res)
+        return NULL;
+
+    if (res->heap_buf) {
+        // only happens without a stack buffer
+        vec_buf_free(res, res->heap_buf, res->capacity * sizeof (long));
+        res->heap_buf = NULL;
+    }
+
+    if (!(vec->flags & VEC_BUF_SHARED)) {
+        // the heap buffer of vec becomes a shared one
+        vec_shared *shared = (vec_shared*)(vec_alloc(vec->allocator, sizeof (vec_shared)));
+
+        if (!shared) {
+            mc_vector_free(res);
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        shared->refs = 1;
+        shared->buf = vec->heap_buf;
+        shared->size = vec->capacity * sizeof (long);
+        shared->align = vec->align;
+        shared->flags = vec->flags;
+
+        vec->heap_buf = NULL;
+        vec->map = shared;
+        vec->flags = VEC_BUF_SHARED;
+    }
+
+    vec_refs_acquire(&((vec_shared*)(vec->map))->refs);
+
+    res->growth = vec->growth;
+    res->align = vec->align;
+    res->flags = VEC_BUF_SHARED;
+    res->map = vec->map;
+    res->data = vec->data;
+    res->capacity = vec->capacity;
+    res->count = vec->count;
+
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+short mc_vector_unshare(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return 1;
+}
+
+vector mc_vector_from_array(long *src, size_t length) {
+    if (!src) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    if (length == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+
+    vector res = mc_vector_make(length * 2);
+
+    if (!res)
+        return NULL;
+
+    memcpy(res->data, src, length * sizeof (long));
+
+    res->capacity = length * 2;
+    res->count = length;
+
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+vector mc_vector_adopt(long *buffer, size_t length, size_t capacity) {
+    if (!buffer) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    if (capacity == 0 || length > capacity || capacity > SIZE_MAX / sizeof (long)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    vector res = mc_vector_make(1);
+
+    if (!res)
+        return NULL;
+
+    if (res->heap_buf)
+        vec_buf_free(res, res->heap_buf, res->capacity * sizeof (long));
+
+    // the buffer is used as is, it is only replaced (and freed) when the vector grows past its capacity
+    res->heap_buf = buffer;
+    res->data = buffer;
+    res->capacity = capacity;
+    res->count = length;
+    res->flags |= VEC_BUF_ADOPTED;
+
+    VEC_STAT_HEAP_ADD(capacity * sizeof (long));
+    VEC_STAT_PEAK(res);
+    return res;
+}
+
+vector mc_vector_move(vector src) {
+    if (!src) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    vector res = mc_vector_make_with(1, src->bufsize, src->allocator);
+
+    if (!res)
+        return NULL;
+
+    if (res->heap_buf) {
+        // only happens without a stack buffer
+        vec_buf_free(res, res->heap_buf, res->capacity * sizeof (long));
+        res->heap_buf = NULL;
+        res->data = res->stack_buf;
+        res->capacity = res->bufsize;
+    }
+
+    res->growth = src->growth;
+    res->align = src->align;
+    res->flags = src->flags;
+    res->count = src->count;
+
+    if (src->data == src->stack_buf) {
+        // inline elements cannot be stolen, there are at most 'bufsize' of them
+        memcpy(res->stack_buf, src->stack_buf, src->count * sizeof (long));
+    }
+    else {
+        // steal the heap buffer, or the file mapping
+        res->heap_buf = src->heap_buf;
+        res->data = src->data;
+        res->capacity = src->capacity;
+        res->map = src->map;
+        res->mapsize = src->mapsize;
+
+        src->heap_buf = NULL;
+        src->map = NULL;
+        src->mapsize = 0;
+        src->data = src->stack_buf;
+        src->capacity = src->bufsize;
+    }
+
+    src->flags = 0;
+    src->count = 0;
+
+    return res;
+}
+
+void mc_vector_free(vector vec) {
+    if (!vec)
+        return;
+
+    if (vec->heap_buf) 
+        vec_buf_free(vec, vec->heap_buf, vec->capacity * sizeof (long));
+
+    vec_unmap(vec);
+    vec_header_free(vec->allocator, vec, sizeof (struct vector_s) + vec->bufsize * sizeof (long));
+}
+
+
+int mc_vector_to_array(vector vec, long *buffer) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return mc_vector_extract(vec, buffer, 0, vec->count);
+}
+
+int mc_vector_extract(vector vec, long *buffer, size_t index, size_t length) {
+    if (!vec || !buffer) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count || length == 0 || index + length > vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    memcpy(buffer, vec->data + index, length * sizeof (long));
+
+    return (int)length;
+}
+
+long *mc_vector_release(vector vec, size_t *length) {
+    if (!vec || !length) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    long *res;
+
+    if (vec_buf_is_malloc(vec)) {
+        // the buffer can be freed by the caller, it is given away without copying anything
+        res = vec->heap_buf;
+        vec->heap_buf = NULL;
+
+        VEC_STAT_HEAP_SUB(vec->capacity * sizeof (long));
+    }
+    else {
+        res = (long*)(malloc((vec->count > 0) ? vec->count * sizeof (long) : sizeof (long)));
+
+        if (!res) {
+            errno = ENOBUFS;
+            return NULL;
+        }
+
+        memcpy(res, vec->data, vec->count * sizeof (long));
+
+        if (vec->heap_buf)
+            vec_buf_free(vec, vec->heap_buf, vec->capacity * sizeof (long));
+
+        vec->heap_buf = NULL;
+        vec_unmap(vec);
+    }
+
+    *length = vec->count;
+
+    vec->data = vec->stack_buf;
+    vec->capacity = vec->bufsize;
+    vec->count = 0;
+    vec->flags = 0;
+
+    return res;
+}
+
+long *mc_vector_data(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    return vec->data;
+}
+
+vector_span mc_vector_span(vector vec) {
+    vector_span res = { NULL, 0 };
+
+    if (!vec) {
+        errno = EFAULT;
+        return res;
+    }
+
+    res.data = vec->data;
+    res.length = vec->count;
+
+    return res;
+}
+
+
+
+
+long *mc_vector_begin(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    return vec->data;
+}
+
+long *mc_vector_end(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return NULL;
+    }
+
+    return vec->data + vec->count;
+}
+
+short mc_vector_for_each(vector vec, void (*fn)(long, void*), void *ctx) {
+    if (!vec || !fn) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    for (const long *it = vec->data, *end = vec->data + vec->count; it != end; it++)
+        fn(*it, ctx);
+
+    return 1;
+}
+
+short mc_vector_transform(vector vec, long (*fn)(long, void*), void *ctx) {
+    if (!vec || !fn) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    for (long *it = vec->data, *end = vec->data + vec->count; it != end; it++)
+        *it = fn(*it, ctx);
+
+    return 1;
+}
+
+
+
+short mc_vector_get(vector vec, size_t index, long *out) {
+    if (!vec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->capacity) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    *out = vec->data[index];
+    return 1;
+}
+
+long mc_vector_get_unchecked(vector vec, size_t index) {
+    if (!vec || index >= vec->capacity) {
+        return LONG_MAX;
+    }
+
+    return vec->data[index];
+}
+
+short mc_vector_set(vector vec, size_t index, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec->data[index] = value;
+    return 1;
+}
+
+
+
+size_t mc_vector_size(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return vec->count;
+}
+
+size_t mc_vector_capacity(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return vec->capacity;
+}
+
+short mc_vector_empty(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 1;
+    }
+
+    return vec->count == 0;
+}
+
+short mc_vector_is_stack(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return vec->data == vec->stack_buf;
+}
+
+short mc_vector_is_shared(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return (vec->flags & VEC_BUF_SHARED) && vec_refs_load(&((vec_shared*)(vec->map))->refs) > 1;
+}
+
+size_t mc_vector_bufsize(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return vec->bufsize;
+}
+
+
+
+
+
+// Computes the capacity the vector should grow to, so that it can hold at least 'needed' elements
+static size_t vec_next_capacity(vector vec, size_t needed) {
+    const size_t maxCap = SIZE_MAX / sizeof (long);
+    size_t cap = vec->capacity;
+
+    switch (vec->growth) {
+        case VGrowth_OneAndHalf:
+        case VGrowth_Page:
+            cap = (cap < maxCap - cap / 2) ? cap + cap / 2 : maxCap;
+            break;
+
+        default:
+            cap = (cap < maxCap / 2) ? cap * 2 : maxCap;
+            break;
+    }
+
+    if (cap < needed)
+        cap = needed;
+
+    if (vec->growth == VGrowth_Page && cap > MC_VECTOR_PAGESIZE / sizeof (long)) {
+        // round the buffer up to a whole number of pages
+        const size_t perPage = MC_VECTOR_PAGESIZE / sizeof (long);
+        cap = (cap <= maxCap - perPage) ? ((cap + perPage - 1) / perPage) * perPage : maxCap;
+    }
+
+    return cap;
+}
+
+static short vec_ensure_capacity(vector vec, size_t len) {
+    if (!vec)
+        return 0;
+
+    if (len > vec->capacity - vec->count) {
+        // need realloc
+        if (len > SIZE_MAX / sizeof (long) - vec->count)
+            return 0;
+
+        const size_t cap = vec_next_capacity(vec, vec->count + len);
+
+        const size_t oldSize = vec->heap_buf ? vec->capacity * sizeof (long) : 0;
+        long *temp = (long*)(vec_buf_realloc(vec, vec->heap_buf, oldSize, cap * sizeof (long)));
+
+        if (!temp)
+            return 0;
+
+        if (vec->data == vec->stack_buf)
+            VEC_STAT(vec, spills, 1);
+        else
+            VEC_STAT(vec, reallocations, 1);
+
+        if (vec->heap_buf == NULL) {
+            // data is either the stack buffer or a file mapping
+            memcpy(temp, vec->data, vec->count * sizeof (long));
+            vec_unmap(vec);
+        }
+
+        vec->heap_buf = temp;
+        vec->data = vec->heap_buf;
+        vec->capacity = cap;
+
+        VEC_STAT_PEAK(vec);
+    }
+    else if (!vec_writable(vec))
+        return 0;
+
+    return 1;
+}
+
+short mc_vector_reserve(vector vec, size_t length) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return 1;
+}
+
+short mc_vector_set_growth(vector vec, vector_growth policy) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (policy != VGrowth_Double && policy != VGrowth_OneAndHalf && policy != VGrowth_Page) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    vec->growth = (unsigned char)(policy);
+    return 1;
+}
+
+short mc_vector_set_alignment(vector vec, size_t alignment) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (alignment < VEC_ALIGN || alignment > MC_VECTOR_MAX_ALIGNMENT || (alignment & (alignment - 1)) != 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    const unsigned char old = vec->align;
+    vec->align = vec_log2(alignment);
+
+    if (vec->data != vec->heap_buf || ((uintptr_t)(vec->heap_buf) & (alignment - 1)) == 0)
+        return 1;
+
+    // the heap buffer does not match the new alignment, move it
+    const size_t size = vec->capacity * sizeof (long);
+    long *temp = (long*)(vec_buf_alloc(vec, size, 0));
+
+    if (!temp) {
+        vec->align = old;
+        errno = ENOMEM;
+        return 0;
+    }
+
+    memcpy(temp, vec->heap_buf, vec->count * sizeof (long));
+    vec_buf_free(vec, vec->heap_buf, size);
+
+    vec->heap_buf = temp;
+    vec->data = temp;
+
+    VEC_STAT(vec, reallocations, 1);
+    return 1;
+}
+
+size_t mc_vector_alignment(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return (size_t)(1) << vec->align;
+}
+
+
+short mc_vector_cache_stats(vector_cache_stats *out) {
+    if (!out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+#ifdef VEC_CACHE
+    *out = vec_cache.stats;
+#else
+    memset(out, 0, sizeof (vector_cache_stats));
+#endif
+
+    return 1;
+}
+
+void mc_vector_cache_flush(void) {
+#ifdef VEC_CACHE
+    while (vec_cache.headers) {
+        void *next = *(void**)(vec_cache.headers);
+        free(vec_cache.headers);
+        vec_cache.headers = next;
+    }
+
+    for (size_t i = 0; i < VEC_CACHE_CLASSES; i++) {
+        while (vec_cache.buffers[i]) {
+            vec_cached *next = vec_cache.buffers[i]->next;
+            vec_buf_free_std(vec_cache.buffers[i]);
+            vec_cache.buffers[i] = next;
+        }
+    }
+
+    memset(&vec_cache, 0, sizeof (vec_cache));
+#endif
+}
+
+vector_stats mc_vector_stats_snapshot(void) {
+    vector_stats res;
+
+#ifdef MC_VECTOR_STATS
+#   if defined(__GNUC__)
+    res.reallocations = __atomic_load_n(&vec_stats.reallocations, __ATOMIC_RELAXED);
+    res.spills = __atomic_load_n(&vec_stats.spills, __ATOMIC_RELAXED);
+    res.moved_bytes = __atomic_load_n(&vec_stats.moved_bytes, __ATOMIC_RELAXED);
+    res.peak_capacity = __atomic_load_n(&vec_stats.peak_capacity, __ATOMIC_RELAXED);
+    res.peak_count = __atomic_load_n(&vec_stats.peak_count, __ATOMIC_RELAXED);
+    res.live_heap_bytes = __atomic_load_n(&vec_stats.live_heap_bytes, __ATOMIC_RELAXED);
+#   else
+    res = vec_stats;
+#   endif
+#else
+    memset(&res, 0, sizeof (vector_stats));
+#endif
+
+    return res;
+}
+
+short mc_vector_stats(vector vec, vector_stats *out) {
+    if (!vec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+#ifdef MC_VECTOR_STATS
+    *out = vec->stats;
+
+    // the inline functions do not update the peaks
+    out->peak_capacity = (vec->capacity > out->peak_capacity) ? vec->capacity : out->peak_capacity;
+    out->peak_count = (vec->count > out->peak_count) ? vec->count : out->peak_count;
+    out->live_heap_bytes = vec->heap_buf ? vec->capacity * sizeof (long) : 0;
+#else
+    memset(out, 0, sizeof (vector_stats));
+#endif
+
+    return 1;
+}
+
+void mc_vector_stats_reset(void) {
+#ifdef MC_VECTOR_STATS
+    const size_t live = vec_stats.live_heap_bytes;
+
+    memset(&vec_stats, 0, sizeof (vector_stats));
+    vec_stats.live_heap_bytes = live;
+#endif
+}
+
+
+
+short mc_vector_push(vector vec, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, 1)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec->data[vec->count++] = value;
+
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+long mc_vector_pop(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return LONG_MIN;
+    }
+
+    if (vec->count == 0) {
+        errno = ENOMEM;
+        return LONG_MIN;
+    }
+
+    long res = vec->data[--vec->count];
+    return res;
+}
+
+short mc_vector_append(vector vec, const long *src, size_t length) {
+    if (!vec || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (length == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    memcpy(vec->data + vec->count, src, length * sizeof (long));
+
+    vec->count += length;
+
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+short mc_vector_append_vector(vector dst, vector src) {
+    if (!dst || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    const size_t length = src->count;
+
+    if (!vec_ensure_capacity(dst, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    // read src->data after growing, since dst and src may be the same vector
+    memcpy(dst->data + dst->count, src->data, length * sizeof (long));
+
+    dst->count += length;
+
+    VEC_STAT_PEAK(dst);
+    return 1;
+}
+
+short mc_vector_push_n(vector vec, long value, size_t length) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (length == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec_fill(vec->data + vec->count, length, value);
+
+    vec->count += length;
+
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+short mc_vector_push_block(vector *vec, long value) {
+    if (!vec || !*vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if ((*vec)->count == (*vec)->capacity
+        && !mc_vector_reserve_block(vec, ((*vec)->capacity * 2) + 1))
+        return 0;
+
+    if (!vec_writable(*vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    (*vec)->data[(*vec)->count++] = value;
+    return 1;
+}
+
+short mc_vector_reserve_block(vector *vec, size_t capacity) {
+    if (!vec || !*vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    vector old = *vec;
+
+    if (capacity < old->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (old->data == old->stack_buf && capacity <= old->bufsize)
+        return 1;
+
+    if (capacity > (SIZE_MAX - sizeof (struct vector_s)) / sizeof (long)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    const size_t bufsize = (capacity > old->bufsize) ? capacity : old->bufsize;
+    vector res = (vector)(vec_realloc(old->allocator, old, sizeof (struct vector_s) + old->bufsize * sizeof (long),
+                                      sizeof (struct vector_s) + bufsize * sizeof (long)));
+
+    if (!res) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    if (res->heap_buf) {
+        // move the elements back into the block
+        memcpy(res->stack_buf, res->heap_buf, res->count * sizeof (long));
+        vec_buf_free(res, res->heap_buf, res->capacity * sizeof (long));
+        res->heap_buf = NULL;
+    }
+    else if (res->map) {
+        memcpy(res->stack_buf, res->data, res->count * sizeof (long));
+        vec_unmap(res);
+    }
+
+    res->data = res->stack_buf;
+    res->bufsize = bufsize;
+    res->capacity = bufsize;
+
+    VEC_STAT(res, reallocations, 1);
+    VEC_STAT_PEAK(res);
+
+    *vec = res;
+    return 1;
+}
+
+
+
+short mc_vector_insert(vector vec, size_t index, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, 1)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    if (index == vec->count-1)
+        return mc_vector_push(vec, value);
+
+    memmove(vec->data + index + 1, vec->data + index, (vec->count - index) * sizeof (long));
+
+    vec->data[index] = value;
+    vec->count++;
+
+    VEC_STAT(vec, moved_bytes, (vec->count - 1 - index) * sizeof (long));
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+short mc_vector_inserts(vector vec, size_t index, long *src, size_t length) {
+    if (!vec || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index > vec->count || length == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_ensure_capacity(vec, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+
+    if (index != vec->count) {
+        memmove(vec->data + index + length, vec->data + index, (vec->count - index) * sizeof (long));
+        VEC_STAT(vec, moved_bytes, (vec->count - index) * sizeof (long));
+    }
+
+    memcpy(vec->data + index, src, length * sizeof (long));
+
+    vec->count += length;
+
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+
+
+
+short mc_vector_remove(vector vec, size_t index) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    memmove(vec->data + index, vec->data + index + 1, (vec->count - index - 1) * sizeof (long));
+    VEC_STAT(vec, moved_bytes, (vec->count - index - 1) * sizeof (long));
+
+    vec->count--;
+
+    return 1;
+}
+
+short mc_vector_swap_remove(vector vec, size_t index) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec->data[index] = vec->data[--vec->count];
+    return 1;
+}
+
+// Keeps the elements for which pred(x, ctx) != 'drop', in a single pass. Returns the number of removed elements
+static size_t vec_compact(vector vec, int (*pred)(long, void*), void *ctx, short drop) {
+    long *data = vec->data;
+    size_t write = 0;
+
+    for (size_t read = 0; read < vec->count; read++) {
+        const long x = data[read];
+
+        // always store, only move the cursor forward for kept elements
+        data[write] = x;
+        write += (pred(x, ctx) != 0) != drop;
+    }
+
+    const size_t removed = vec->count - write;
+
+    vec->count = write;
+    return removed;
+}
+
+size_t mc_vector_remove_if(vector vec, int (*pred)(long, void*), void *ctx) {
+    if (!vec || !pred) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return vec_compact(vec, pred, ctx, 1);
+}
+
+size_t mc_vector_retain(vector vec, int (*pred)(long, void*), void *ctx) {
+    if (!vec || !pred) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return vec_compact(vec, pred, ctx, 0);
+}
+
+short mc_vector_erase(vector vec, size_t index, size_t length) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count || length == 0 || length > vec->count - index) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    memmove(vec->data + index, vec->data + index + length, (vec->count - index - length) * sizeof (long));
+    VEC_STAT(vec, moved_bytes, (vec->count - index - length) * sizeof (long));
+
+    vec->count -= length;
+    return 1;
+}
+
+
+// Exchanges the storage descriptors (heap buffer or file mapping) of two vectors, inline elements are not touched
+static void vec_swap_storage(vector vec1, vector vec2) {
+    long *data1 = (vec1->data == vec1->stack_buf) ? vec2->stack_buf : vec1->data;
+    long *data2 = (vec2->data == vec2->stack_buf) ? vec1->stack_buf : vec2->data;
+
+    long *heap_buf = vec1->heap_buf;
+    void *map = vec1->map;
+    size_t mapsize = vec1->mapsize;
+    size_t capacity = vec1->capacity;
+    unsigned char align = vec1->align;
+    unsigned char flags = vec1->flags;
+
+    vec1->heap_buf = vec2->heap_buf;
+    vec1->map = vec2->map;
+    vec1->mapsize = vec2->mapsize;
+    vec1->capacity = (data2 == vec1->stack_buf) ? vec1->bufsize : vec2->capacity;
+    vec1->align = vec2->align;
+    vec1->flags = vec2->flags;
+    vec1->data = data2;
+
+    vec2->heap_buf = heap_buf;
+    vec2->map = map;
+    vec2->mapsize = mapsize;
+    vec2->capacity = (data1 == vec2->stack_buf) ? vec2->bufsize : capacity;
+    vec2->align = align;
+    vec2->flags = flags;
+    vec2->data = data1;
+}
+
+// Exchanges the elements of two buffers, each one being big enough for the elements of the other
+static void vec_swap_elements(long *a, size_t countA, long *b, size_t countB) {
+    const size_t common = min(countA, countB);
+
+    for (size_t i = 0; i < common; i++) {
+        const long temp = a[i];
+        a[i] = b[i];
+        b[i] = temp;
+    }
+
+    if (countA > common)
+        memcpy(b + common, a + common, (countA - common) * sizeof (long));
+    else
+        memcpy(a + common, b + common, (countB - common) * sizeof (long));
+}
+
+// Makes room for 'length' elements in total
+static short vec_ensure_total(vector vec, size_t length) {
+    return vec_ensure_capacity(vec, (length > vec->count) ? length - vec->count : 0);
+}
+
+short mc_vector_swap(vector vec1, vector vec2) {
+    if (!vec1 || !vec2) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec1 == vec2)
+        return 1;
+
+    if (vec1->allocator != vec2->allocator) {
+        // buffers must stay with the allocator which gave them, so the elements are exchanged instead
+        if (!vec_ensure_total(vec1, vec2->count) || !vec_ensure_total(vec2, vec1->count)) {
+            errno = ENOMEM;
+            return 0;
+        }
+
+        vec_swap_elements(vec1->data, vec1->count, vec2->data, vec2->count);
+    }
+    else {
+        // inline elements which would not fit in the stack buffer of the other vector are moved to the heap first
+        if ((vec1->data == vec1->stack_buf && vec1->count > vec2->bufsize
+                && !vec_ensure_capacity(vec1, vec1->bufsize + 1 - vec1->count))
+            || (vec2->data == vec2->stack_buf && vec2->count > vec1->bufsize
+                && !vec_ensure_capacity(vec2, vec2->bufsize + 1 - vec2->count))) {
+            errno = ENOMEM;
+            return 0;
+        }
+
+        const short stack1 = vec1->data == vec1->stack_buf;
+        const short stack2 = vec2->data == vec2->stack_buf;
+
+        if (stack1 && stack2) {
+            // at most 'bufsize' elements on each side
+            vec_swap_elements(vec1->stack_buf, vec1->count, vec2->stack_buf, vec2->count);
+        }
+        else {
+            if (stack1)
+                memcpy(vec2->stack_buf, vec1->stack_buf, vec1->count * sizeof (long));
+            else if (stack2)
+                memcpy(vec1->stack_buf, vec2->stack_buf, vec2->count * sizeof (long));
+
+            // nothing is copied if both vectors are on the heap
+            vec_swap_storage(vec1, vec2);
+        }
+    }
+
+    const size_t count = vec1->count;
+    vec1->count = vec2->count;
+    vec2->count = count;
+
+    return 1;
+}
+
+short mc_vector_move_assign(vector dst, vector src) {
+    if (!dst || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (dst == src)
+        return 1;
+
+    if (src->data != src->stack_buf && dst->allocator == src->allocator) {
+        // the storage of dst is dropped, and replaced by the one of src
+        if (dst->heap_buf)
+            vec_buf_free(dst, dst->heap_buf, dst->capacity * sizeof (long));
+
+        vec_unmap(dst);
+
+        dst->heap_buf = NULL;
+        dst->data = dst->stack_buf;
+        dst->capacity = dst->bufsize;
+        dst->flags = 0;
+
+        vec_swap_storage(dst, src);
+
+        dst->count = src->count;
+        src->count = 0;
+    }
+    else {
+        // old elements of dst are not kept if it has to grow
+        const size_t count = dst->count;
+        dst->count = 0;
+
+        if (!vec_ensure_total(dst, src->count)) {
+            dst->count = count;
+            errno = ENOMEM;
+            return 0;
+        }
+
+        memcpy(dst->data, src->data, src->count * sizeof (long));
+
+        dst->count = src->count;
+        mc_vector_clear(src);
+    }
+
+    return 1;
+}
+
+short mc_vector_fill(vector vec, long value) {
+    return mc_vector_fill_range(vec, 0, vec->count, value);
+}
+
+short mc_vector_fill_range(vector vec, size_t index, size_t length, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count || length == 0 || index + length > vec->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec_fill(vec->data + index, length, value);
+
+    return 1;
+}
+
+
+
+short mc_vector_shrink(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+#ifdef VEC_MMAP
+    if (vec->data == vec->heap_buf && !(vec->flags & VEC_BUF_ADOPTED)
+        && vec_is_mapped(vec, vec->capacity * sizeof (long))) {
+        // keep the mapping (and the capacity), only the memory past the last element is given back
+        vec_map_release(vec->heap_buf, vec->count * sizeof (long), vec->capacity * sizeof (long));
+        return 1;
+    }
+#endif
+
+    return mc_vector_resize(vec, vec->count);
+}
+
+short mc_vector_resize(vector vec, size_t newSize) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (newSize == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    // elements located outside of the new buffer are lost
+    vec->count = min(vec->count, newSize);
+
+    if (newSize <= vec->bufsize) {
+        // new size is small enough to fit in the stack buffer
+        if (vec->data == vec->heap_buf) {
+            // we have to copy the content from the heap buffer and free it
+            memcpy(vec->stack_buf, vec->heap_buf, vec->count * sizeof (long));
+            vec_buf_free(vec, vec->heap_buf, vec->capacity * sizeof (long));
+            vec->heap_buf = NULL;
+            VEC_STAT(vec, reallocations, 1);
+        }
+        else if (vec->map) {
+            memcpy(vec->stack_buf, vec->data, vec->count * sizeof (long));
+            vec_unmap(vec);
+            VEC_STAT(vec, reallocations, 1);
+        }
+
+        vec->data = vec->stack_buf;
+        vec->capacity = vec->bufsize;
+    }
+    else {
+        // new size is too big for stack buffer
+        if (vec->data == vec->heap_buf) {
+            // we already have allocated a buffer, just realloc it
+            long *temp = (long*)(vec_buf_realloc(vec, vec->heap_buf, vec->capacity * sizeof (long),
+                                             newSize * sizeof (long)));
+
+            if (!temp) {
+                errno = ENOMEM;
+                return 0;
+            }
+
+            vec->heap_buf = temp;
+            VEC_STAT(vec, reallocations, 1);
+        }
+        else {
+            // we need to alloc a new buffer, and copy the content from the stack buffer (or the file mapping)
+            long *temp = (long*)(vec_buf_alloc(vec, newSize * sizeof (long), 0));
+
+            if (!temp) {
+                errno = ENOMEM;
+                return 0;
+            }
+
+            if (vec->data == vec->stack_buf)
+                VEC_STAT(vec, spills, 1);
+            else
+                VEC_STAT(vec, reallocations, 1);
+
+            memcpy(temp, vec->data, vec->count * sizeof (long));
+            vec_unmap(vec);
+            vec->heap_buf = temp;
+        }
+
+        // now update attributes
+        vec->data = vec->heap_buf;
+        vec->capacity = newSize;
+
+        VEC_STAT_PEAK(vec);
+    }
+
+    return 1;
+}
+
+short mc_vector_clear(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+#ifdef VEC_MMAP
+    if (vec->data == vec->heap_buf && !(vec->flags & VEC_BUF_ADOPTED)
+        && vec_is_mapped(vec, vec->capacity * sizeof (long))) {
+        // keep the mapping, so that the vector can be filled again without growing
+        vec_map_release(vec->heap_buf, 0, vec->capacity * sizeof (long));
+        vec->count = 0;
+        return 1;
+    }
+#endif
+
+    if (vec->data != vec->stack_buf) {
+        // free the buffer
+        vec_buf_free(vec, vec->heap_buf, vec->capacity * sizeof (long));
+        vec_unmap(vec);
+        vec->heap_buf = NULL;
+        vec->data = vec->stack_buf;
+        vec->capacity = vec->bufsize;
+    }
+
+    vec->count = 0;
+    return 1;
+}
+
+
+
+
+// Reduction kernels. SIMD kernels are only used when long is 64-bit wide, they all require length > 0
+
+#if LONG_MAX > 2147483647L
+#   if defined(VEC_X86)
+#       define VEC_X86_LONG64
+#   elif defined(VEC_NEON)
+#       define VEC_NEON_LONG64
+#   endif
+#endif
+
+static long vec_sum_scalar(const long *src, size_t length) {
+    // unsigned arithmetic, so that overflow wraps around instead of being undefined
+    unsigned long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        s0 += (unsigned long)(src[i]);
+        s1 += (unsigned long)(src[i + 1]);
+        s2 += (unsigned long)(src[i + 2]);
+        s3 += (unsigned long)(src[i + 3]);
+    }
+
+    for (; i < length; i++)
+        s0 += (unsigned long)(src[i]);
+
+    return (long)(s0 + s1 + s2 + s3);
+}
+
+static void vec_minmax_scalar(const long *src, size_t length, long *outMin, long *outMax) {
+    long min0 = src[0], min1 = src[0], max0 = src[0], max1 = src[0];
+    size_t i = 1;
+
+    for (; i + 2 <= length; i += 2) {
+        min0 = (src[i] < min0) ? src[i] : min0;
+        max0 = (src[i] > max0) ? src[i] : max0;
+        min1 = (src[i + 1] < min1) ? src[i + 1] : min1;
+        max1 = (src[i + 1] > max1) ? src[i + 1] : max1;
+    }
+
+    for (; i < length; i++) {
+        min0 = (src[i] < min0) ? src[i] : min0;
+        max0 = (src[i] > max0) ? src[i] : max0;
+    }
+
+    *outMin = min(min0, min1);
+    *outMax = (max0 > max1) ? max0 : max1;
+}
+
+static long vec_dot_scalar(const long *a, const long *b, size_t length) {
+    unsigned long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        s0 += (unsigned long)(a[i]) * (unsigned long)(b[i]);
+        s1 += (unsigned long)(a[i + 1]) * (unsigned long)(b[i + 1]);
+        s2 += (unsigned long)(a[i + 2]) * (unsigned long)(b[i + 2]);
+        s3 += (unsigned long)(a[i + 3]) * (unsigned long)(b[i + 3]);
+    }
+
+    for (; i < length; i++)
+        s0 += (unsigned long)(a[i]) * (unsigned long)(b[i]);
+
+    return (long)(s0 + s1 + s2 + s3);
+}
+
+#ifdef VEC_X86_LONG64
+
+VEC_TARGET("avx2")
+static long vec_sum_avx2(const long *src, size_t length) {
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        a0 = _mm256_add_epi64(a0, _mm256_loadu_si256((const __m256i*)(src + i)));
+        a1 = _mm256_add_epi64(a1, _mm256_loadu_si256((const __m256i*)(src + i + 4)));
+        a2 = _mm256_add_epi64(a2, _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+        a3 = _mm256_add_epi64(a3, _mm256_loadu_si256((const __m256i*)(src + i + 12)));
+    }
+
+    long lanes[4];
+    _mm256_storeu_si256((__m256i*)(lanes), _mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3)));
+
+    return (long)((unsigned long)(vec_sum_scalar(lanes, 4)) + (unsigned long)(vec_sum_scalar(src + i, length - i)));
+}
+
+VEC_TARGET("avx512f")
+static long vec_sum_avx512(const long *src, size_t length) {
+    __m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        a0 = _mm512_add_epi64(a0, _mm512_loadu_si512((const void*)(src + i)));
+        a1 = _mm512_add_epi64(a1, _mm512_loadu_si512((const void*)(src + i + 8)));
+        a2 = _mm512_add_epi64(a2, _mm512_loadu_si512((const void*)(src + i + 16)));
+        a3 = _mm512_add_epi64(a3, _mm512_loadu_si512((const void*)(src + i + 24)));
+    }
+
+    long lanes[8];
+    _mm512_storeu_si512((void*)(lanes), _mm512_add_epi64(_mm512_add_epi64(a0, a1), _mm512_add_epi64(a2, a3)));
+
+    const long head = vec_sum_scalar(lanes, 8);
+
+    return (long)((unsigned long)(head) + (unsigned long)(vec_sum_scalar(src + i, length - i)));
+}
+
+VEC_TARGET("avx2")
+static void vec_minmax_avx2(const long *src, size_t length, long *outMin, long *outMax) {
+    __m256i min0 = _mm256_set1_epi64x(src[0]), min1 = min0, max0 = min0, max1 = min0;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        const __m256i x0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        const __m256i x1 = _mm256_loadu_si256((const __m256i*)(src + i + 4));
+
+        min0 = _mm256_blendv_epi8(min0, x0, _mm256_cmpgt_epi64(min0, x0));
+        min1 = _mm256_blendv_epi8(min1, x1, _mm256_cmpgt_epi64(min1, x1));
+        max0 = _mm256_blendv_epi8(max0, x0, _mm256_cmpgt_epi64(x0, max0));
+        max1 = _mm256_blendv_epi8(max1, x1, _mm256_cmpgt_epi64(x1, max1));
+    }
+
+    long lanes[16];
+    _mm256_storeu_si256((__m256i*)(lanes), min0);
+    _mm256_storeu_si256((__m256i*)(lanes + 4), min1);
+    _mm256_storeu_si256((__m256i*)(lanes + 8), max0);
+    _mm256_storeu_si256((__m256i*)(lanes + 12), max1);
+
+    long ignored, tailMin = src[0], tailMax = src[0];
+
+    if (i < length)
+        vec_minmax_scalar(src + i, length - i, &tailMin, &tailMax);
+
+    vec_minmax_scalar(lanes, 8, outMin, &ignored);
+    vec_minmax_scalar(lanes + 8, 8, &ignored, outMax);
+
+    *outMin = min(*outMin, tailMin);
+    *outMax = (*outMax > tailMax) ? *outMax : tailMax;
+}
+
+VEC_TARGET("avx512f")
+static void vec_minmax_avx512(const long *src, size_t length, long *outMin, long *outMax) {
+    __m512i min0 = _mm512_set1_epi64(src[0]), min1 = min0, max0 = min0, max1 = min0;
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        const __m512i x0 = _mm512_loadu_si512((const void*)(src + i));
+        const __m512i x1 = _mm512_loadu_si512((const void*)(src + i + 8));
+
+        min0 = _mm512_min_epi64(min0, x0);
+        min1 = _mm512_min_epi64(min1, x1);
+        max0 = _mm512_max_epi64(max0, x0);
+        max1 = _mm512_max_epi64(max1, x1);
+    }
+
+    long tailMin = src[0], tailMax = src[0];
+
+    if (i < length)
+        vec_minmax_scalar(src + i, length - i, &tailMin, &tailMax);
+
+    const long headMin = _mm512_reduce_min_epi64(_mm512_min_epi64(min0, min1));
+    const long headMax = _mm512_reduce_max_epi64(_mm512_max_epi64(max0, max1));
+
+    *outMin = min(headMin, tailMin);
+    *outMax = (headMax > tailMax) ? headMax : tailMax;
+}
+
+VEC_TARGET("avx512f,avx512dq")
+static long vec_dot_avx512(const long *a, const long *b, size_t length) {
+    __m512i a0 = _mm512_setzero_si512(), a1 = a0;
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        const __m512i x0 = _mm512_loadu_si512((const void*)(a + i));
+        const __m512i x1 = _mm512_loadu_si512((const void*)(a + i + 8));
+        const __m512i y0 = _mm512_loadu_si512((const void*)(b + i));
+        const __m512i y1 = _mm512_loadu_si512((const void*)(b + i + 8));
+
+        a0 = _mm512_add_epi64(a0, _mm512_mullo_epi64(x0, y0));
+        a1 = _mm512_add_epi64(a1, _mm512_mullo_epi64(x1, y1));
+    }
+
+    long lanes[8];
+    _mm512_storeu_si512((void*)(lanes), _mm512_add_epi64(a0, a1));
+
+    const long head = vec_sum_scalar(lanes, 8);
+
+    return (long)((unsigned long)(head) + (unsigned long)(vec_dot_scalar(a + i, b + i, length - i)));
+}
+
+#endif /* VEC_X86_LONG64 */
+
+#ifdef VEC_NEON_LONG64
+
+static long vec_sum_neon(const long *src, size_t length) {
+    int64x2_t a0 = vdupq_n_s64(0), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        a0 = vaddq_s64(a0, vld1q_s64((const int64_t*)(src + i)));
+        a1 = vaddq_s64(a1, vld1q_s64((const int64_t*)(src + i + 2)));
+        a2 = vaddq_s64(a2, vld1q_s64((const int64_t*)(src + i + 4)));
+        a3 = vaddq_s64(a3, vld1q_s64((const int64_t*)(src + i + 6)));
+    }
+
+    const long head = (long)(vaddvq_s64(vaddq_s64(vaddq_s64(a0, a1), vaddq_s64(a2, a3))));
+
+    return (long)((unsigned long)(head) + (unsigned long)(vec_sum_scalar(src + i, length - i)));
+}
+
+static void vec_minmax_neon(const long *src, size_t length, long *outMin, long *outMax) {
+    int64x2_t mn = vdupq_n_s64(src[0]), mx = mn;
+    size_t i = 0;
+
+    for (; i + 2 <= length; i += 2) {
+        const int64x2_t x = vld1q_s64((const int64_t*)(src + i));
+
+        mn = vbslq_s64(vcgtq_s64(mn, x), x, mn);
+        mx = vbslq_s64(vcgtq_s64(x, mx), x, mx);
+    }
+
+    long lanes[4] = { vgetq_lane_s64(mn, 0), vgetq_lane_s64(mn, 1), vgetq_lane_s64(mx, 0), vgetq_lane_s64(mx, 1) };
+    long ignored;
+
+    if (i < length) {
+        lanes[0] = min(lanes[0], src[i]);
+        lanes[2] = (lanes[2] > src[i]) ? lanes[2] : src[i];
+    }
+
+    vec_minmax_scalar(lanes, 2, outMin, &ignored);
+    vec_minmax_scalar(lanes + 2, 2, &ignored, outMax);
+}
+
+#endif /* VEC_NEON_LONG64 */
+
+
+static long vec_sum(const long *src, size_t length) {
+#if defined(VEC_X86_LONG64)
+    if (length >= 32 && __builtin_cpu_supports("avx512f"))
+        return vec_sum_avx512(src, length);
+    if (length >= 16 && __builtin_cpu_supports("avx2"))
+        return vec_sum_avx2(src, length);
+#elif defined(VEC_NEON_LONG64)
+    if (length >= 8)
+        return vec_sum_neon(src, length);
+#endif
+
+    return vec_sum_scalar(src, length);
+}
+
+static void vec_minmax(const long *src, size_t length, long *outMin, long *outMax) {
+#if defined(VEC_X86_LONG64)
+    if (length >= 16 && __builtin_cpu_supports("avx512f")) {
+        vec_minmax_avx512(src, length, outMin, outMax);
+        return;
+    }
+    if (length >= 8 && __builtin_cpu_supports("avx2")) {
+        vec_minmax_avx2(src, length, outMin, outMax);
+        return;
+    }
+#elif defined(VEC_NEON_LONG64)
+    if (length >= 4) {
+        vec_minmax_neon(src, length, outMin, outMax);
+        return;
+    }
+#endif
+
+    vec_minmax_scalar(src, length, outMin, outMax);
+}
+
+static long vec_dot(const long *a, const long *b, size_t length) {
+#if defined(VEC_X86_LONG64)
+    if (length >= 16 && __builtin_cpu_supports("avx512dq"))
+        return vec_dot_avx512(a, b, length);
+#endif
+
+    return vec_dot_scalar(a, b, length);
+}
+
+// Exact sum: returns 0 if the result does not fit in a long
+static short vec_sum_exact(const long *src, size_t length, long *out) {
+#if LONG_MAX > 2147483647L
+    // every element is split into a signed high half and an unsigned low half, whose sums can't overflow on a block
+    // of 2^30 elements. The running total is high * 2^32 + low, with 0 <= low < 2^32
+    const size_t block = (size_t)(1) << 30;
+    long long high = 0;
+    unsigned long long low = 0;
+    size_t i = 0;
+
+    while (i < length) {
+        const size_t end = (length - i > block) ? i + block : length;
+        long long sumHigh = 0;
+        unsigned long long sumLow = 0;
+
+        for (; i < end; i++) {
+            sumHigh += src[i] >> 32;
+            sumLow += (unsigned long long)(src[i]) & 0xFFFFFFFFULL;
+        }
+
+        low += sumLow;
+        high += sumHigh + (long long)(low >> 32);
+        low &= 0xFFFFFFFFULL;
+    }
+
+    if (high < -2147483647LL - 1 || high > 2147483647LL)
+        return 0;
+
+    *out = (long)(((unsigned long long)(high) << 32) | low);
+    return 1;
+#else
+    long long sum = 0;
+
+    for (size_t i = 0; i < length; i++)
+        sum += src[i];
+
+    if (sum < LONG_MIN || sum > LONG_MAX)
+        return 0;
+
+    *out = (long)(sum);
+    return 1;
+#endif
+}
+
+// Exact dot product: returns 0 if the result (or an intermediate sum) does not fit
+static short vec_dot_exact(const long *a, const long *b, size_t length, long *out) {
+#if LONG_MAX <= 2147483647L
+    long long sum = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        const long long p = (long long)(a[i]) * b[i];
+
+        if ((p > 0 && sum > LLONG_MAX - p) || (p < 0 && sum < LLONG_MIN - p))
+            return 0;
+
+        sum += p;
+    }
+
+    if (sum < LONG_MIN || sum > LONG_MAX)
+        return 0;
+
+    *out = (long)(sum);
+    return 1;
+#elif defined(__SIZEOF_INT128__)
+    __extension__ typedef __int128 vec_int128;
+    vec_int128 sum = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if (__builtin_add_overflow(sum, (vec_int128)(a[i]) * b[i], &sum))
+            return 0;
+    }
+
+    if (sum < LONG_MIN || sum > LONG_MAX)
+        return 0;
+
+    *out = (long)(sum);
+    return 1;
+#else
+    long sum = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        long p;
+
+        if (a[i] != 0 && (b[i] > LONG_MAX / a[i] || b[i] < LONG_MIN / a[i])
+            && !(a[i] == -1 && b[i] != LONG_MIN) && !(b[i] == -1 && a[i] != LONG_MIN))
+            return 0;
+
+        p = a[i] * b[i];
+
+        if ((p > 0 && sum > LONG_MAX - p) || (p < 0 && sum < LONG_MIN - p))
+            return 0;
+
+        sum += p;
+    }
+
+    *out = sum;
+    return 1;
+#endif
+}
+
+
+short mc_vector_sum(vector vec, long *out) {
+    if (!vec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    *out = vec_sum(vec->data, vec->count);
+    return 1;
+}
+
+short mc_vector_sum_checked(vector vec, long *out) {
+    if (!vec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_sum_exact(vec->data, vec->count, out)) {
+        errno = ERANGE;
+        return 0;
+    }
+
+    return 1;
+}
+
+short mc_vector_min(vector vec, long *out) {
+    long ignored;
+    return mc_vector_minmax(vec, out, &ignored);
+}
+
+short mc_vector_max(vector vec, long *out) {
+    long ignored;
+    return mc_vector_minmax(vec, &ignored, out);
+}
+
+short mc_vector_minmax(vector vec, long *outMin, long *outMax) {
+    if (!vec || !outMin || !outMax) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec->count == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    vec_minmax(vec->data, vec->count, outMin, outMax);
+    return 1;
+}
+
+short mc_vector_dot(vector vec1, vector vec2, long *out) {
+    if (!vec1 || !vec2 || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec1->count != vec2->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    *out = vec_dot(vec1->data, vec2->data, vec1->count);
+    return 1;
+}
+
+short mc_vector_dot_checked(vector vec1, vector vec2, long *out) {
+    if (!vec1 || !vec2 || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec1->count != vec2->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_dot_exact(vec1->data, vec2->data, vec1->count, out)) {
+        errno = ERANGE;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+
+
+// Gather and scatter. Indices are all checked before any element is moved, SIMD kernels need 64-bit longs
+
+// Returns 1 if every index is a valid position (negative indices become huge unsigned ones)
+static short vec_indices_valid(const long *indices, size_t length, size_t count) {
+    short invalid = 0;
+
+    // no early exit, so that the loop is vectorized
+    for (size_t i = 0; i < length; i++)
+        invalid |= (size_t)(indices[i]) >= count;
+
+    return !invalid;
+}
+
+#ifdef VEC_X86_LONG64
+
+VEC_TARGET("avx2")
+static void vec_gather_avx2(long *dst, const long *src, const long *indices, size_t length) {
+    size_t i = 0;
+
+    // indices are loaded before the elements are stored, so that dst may be indices
+    for (; i + 8 <= length; i += 8) {
+        const __m256i i0 = _mm256_loadu_si256((const __m256i*)(indices + i));
+        const __m256i i1 = _mm256_loadu_si256((const __m256i*)(indices + i + 4));
+        const __m256i x0 = _mm256_i64gather_epi64((const long long*)(src), i0, 8);
+        const __m256i x1 = _mm256_i64gather_epi64((const long long*)(src), i1, 8);
+
+        _mm256_storeu_si256((__m256i*)(dst + i), x0);
+        _mm256_storeu_si256((__m256i*)(dst + i + 4), x1);
+    }
+
+    for (; i < length; i++)
+        dst[i] = src[indices[i]];
+}
+
+VEC_TARGET("avx512f")
+static void vec_gather_avx512(long *dst, const long *src, const long *indices, size_t length) {
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        const __m512i idx = _mm512_loadu_si512((const void*)(indices + i));
+
+        _mm512_storeu_si512((void*)(dst + i), _mm512_i64gather_epi64(idx, (const void*)(src), 8));
+    }
+
+    for (; i < length; i++)
+        dst[i] = src[indices[i]];
+}
+
+VEC_TARGET("avx512f")
+static void vec_scatter_avx512(long *dst, const long *indices, const long *values, size_t length) {
+    size_t i = 0;
+
+    // overlapping lanes are written in order, so that the last value still wins
+    for (; i + 8 <= length; i += 8) {
+        const __m512i idx = _mm512_loadu_si512((const void*)(indices + i));
+
+        _mm512_i64scatter_epi64((void*)(dst), idx, _mm512_loadu_si512((const void*)(values + i)), 8);
+    }
+
+    for (; i < length; i++)
+        dst[indices[i]] = values[i];
+}
+
+#endif /* VEC_X86_LONG64 */
+
+static void vec_gather(long *dst, const long *src, const long *indices, size_t length) {
+#if defined(VEC_X86_LONG64)
+    if (length >= 16 && __builtin_cpu_supports("avx512f")) {
+        vec_gather_avx512(dst, src, indices, length);
+        return;
+    }
+    if (length >= 16 && __builtin_cpu_supports("avx2")) {
+        vec_gather_avx2(dst, src, indices, length);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < length; i++)
+        dst[i] = src[indices[i]];
+}
+
+static void vec_scatter(long *dst, const long *indices, const long *values, size_t length) {
+#if defined(VEC_X86_LONG64)
+    if (length >= 16 && __builtin_cpu_supports("avx512f")) {
+        vec_scatter_avx512(dst, indices, values, length);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < length; i++)
+        dst[indices[i]] = values[i];
+}
+
+
+short mc_vector_gather(vector vec, vector indices, vector out) {
+    if (!vec || !indices || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    const size_t length = indices->count;
+
+    if (out == vec || !vec_indices_valid(indices->data, length, vec->count)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    // nothing to reserve if out is indices
+    if (!vec_ensure_total(out, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec_gather(out->data, vec->data, indices->data, length);
+    out->count = length;
+
+    VEC_STAT_PEAK(out);
+    return 1;
+}
+
+short mc_vector_scatter(vector vec, vector indices, vector values) {
+    if (!vec || !indices || !values) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    const size_t length = indices->count;
+
+    if (vec == indices || vec == values || values->count != length
+        || !vec_indices_valid(indices->data, length, vec->count)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    vec_scatter(vec->data, indices->data, values->data, length);
+    return 1;
+}
+
+
+
+
+// Sorting. Small inputs (and custom orderings) use an introsort, bigger ones an LSD radix sort
+
+// Inputs smaller than this are sorted with the introsort
+#ifndef MC_VECTOR_RADIX_MIN
+#   define MC_VECTOR_RADIX_MIN 256
+#endif
+
+typedef struct {
+    int  (*compare)(long, long, void*);     // The user comparator
+    void  *ctx;                             // Passed to every call of the comparator
+} vec_order;
+
+#define vec_less_natural(a, b, order)   ((void)(order), (a) < (b))
+#define vec_less_custom(a, b, order)    ((order)->compare((a), (b), (order)->ctx) < 0)
+
+#define vec_swap_long(a, b) do { long t_ = (a); (a) = (b); (b) = t_; } while (0)
+
+// Defines an introsort (quicksort + heapsort + insertion sort) using 'less' to compare elements
+#define VEC_DEFINE_INTROSORT(name, less)                                                                            \
+static void name##_insertion(long *data, size_t length, const vec_order *order) {                                   \
+    for (size_t i = 1; i < length; i++) {                                                                           \
+        const long x = data[i];                                                                                     \
+        size_t j = i;                                                                                               \
+                                                                                                                    \
+        for (; j > 0 && less(x, data[j - 1], order); j--)                                                           \
+            data[j] = data[j - 1];                                                                                  \
+                                                                                                                    \
+        data[j] = x;                                                                                                \
+    }                                                                                                               \
+}                                                                                                                   \
+                                                                                                                    \
+static void name##_sift(long *data, size_t root, size_t length, const vec_order *order) {                           \
+    for (size_t child; (child = 2 * root + 1) < length; root = child) {                                             \
+        if (child + 1 < length && less(data[child], data[child + 1], order))                                        \
+            child++;                                                                                                \
+                                                                                                                    \
+        if (!less(data[root], data[child], order))                                                                  \
+            return;                                                                                                 \
+                                                                                                                    \
+        vec_swap_long(data[root], data[child]);                                                                     \
+    }                                                                                                               \
+}                                                                                                                   \
+                                                                                                                    \
+static void name##_heapsort(long *data, size_t length, const vec_order *order) {                                    \
+    for (size_t i = length / 2; i-- > 0;)                                                                           \
+        name##_sift(data, i, length, order);                                                                        \
+                                                                                                                    \
+    for (size_t end = length; end-- > 1;) {                                                                         \
+        vec_swap_long(data[0], data[end]);                                                                          \
+        name##_sift(data, 0, end, order);                                                                           \
+    }                                                                                                               \
+}                                                                                                                   \
+                                                                                                                    \
+static void name(long *data, size_t length, size_t depth, const vec_order *order) {                                 \
+    while (length > 16) {                                                                                           \
+        if (depth-- == 0) {                                                                                         \
+            name##_heapsort(data, length, order);                                                                   \
+            return;                                                                                                 \
+        }                                                                                                           \
+                                                                                                                    \
+        /* median of three, moved to data[0] */                                                                     \
+        const size_t mid = length / 2;                                                                              \
+                                                                                                                    \
+        if (less(data[mid], data[0], order))                                                                        \
+            vec_swap_long(data[mid], data[0]);                                                                      \
+        if (less(data[length - 1], data[mid], order)) {                                                             \
+            vec_swap_long(data[length - 1], data[mid]);                                                             \
+            if (less(data[mid], data[0], order))                                                                    \
+                vec_swap_long(data[mid], data[0]);                                                                  \
+        }                                                                                                           \
+        vec_swap_long(data[0], data[mid]);                                                                          \
+                                                                                                                    \
+        /* Hoare partition around data[0] */                                                                        \
+        const long pivot = data[0];                                                                                 \
+        size_t i = 0, j = length;                                                                                   \
+                                                                                                                    \
+        for (;;) {                                                                                                  \
+            do { i++; } while (less(data[i], pivot, order));                                                        \
+            do { j--; } while (less(pivot, data[j], order));                                                        \
+                                                                                                                    \
+            if (i >= j)                                                                                             \
+                break;                                                                                              \
+                                                                                                                    \
+            vec_swap_long(data[i], data[j]);                                                                        \
+        }                                                                                                           \
+                                                                                                                    \
+        vec_swap_long(data[0], data[j]);                                                                            \
+                                                                                                                    \
+        /* recurse on the smaller side, loop on the bigger one */                                                   \
+        if (j < length - j - 1) {                                                                                   \
+            name(data, j, depth, order);                                                                            \
+            data += j + 1;                                                                                          \
+            length -= j + 1;                                                                                        \
+        }                                                                                                           \
+        else {                                                                                                      \
+            name(data + j + 1, length - j - 1, depth, order);                                                       \
+            length = j;                                                                                             \
+        }                                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    name##_insertion(data, length, order);                                                                          \
+}
+
+VEC_DEFINE_INTROSORT(vec_introsort, vec_less_natural)
+VEC_DEFINE_INTROSORT(vec_introsort_by, vec_less_custom)
+
+// The depth after which the introsort switches to heapsort (2 * log2(length))
+static size_t vec_sort_depth(size_t length) {
+    size_t depth = 0;
+
+    while (length >>= 1)
+        depth += 2;
+
+    return depth;
+}
+
+// LSD radix sort, one byte per pass. 'scratch' must be able to hold 'length' elements
+static void vec_radix_sort(long *data, long *scratch, size_t length) {
+    const unsigned long sign = (unsigned long)(1) << (sizeof (long) * CHAR_BIT - 1);
+    size_t counts[sizeof (long)][256];
+    long *src = data, *dst = scratch;
+
+    // every histogram is computed in a single pass. Flipping the sign bit makes signed order match unsigned order
+    memset(counts, 0, sizeof (counts));
+
+    for (size_t i = 0; i < length; i++) {
+        const unsigned long key = (unsigned long)(data[i]) ^ sign;
+
+        for (size_t pass = 0; pass < sizeof (long); pass++)
+            counts[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    for (size_t pass = 0; pass < sizeof (long); pass++) {
+        size_t *count = counts[pass];
+        const unsigned shift = (unsigned)(pass * 8);
+
+        // if every element has the same byte, this pass would not move anything
+        if (count[(((unsigned long)(data[0]) ^ sign) >> shift) & 0xFF] == length)
+            continue;
+
+        size_t offset = 0;
+
+        for (size_t b = 0; b < 256; b++) {
+            const size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            const unsigned long key = (unsigned long)(src[i]) ^ sign;
+            dst[count[(key >> shift) & 0xFF]++] = src[i];
+        }
+
+        long *temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != data)
+        memcpy(data, src, length * sizeof (long));
+}
+
+
+short mc_vector_sort(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    const size_t length = vec->count;
+
+    if (length < MC_VECTOR_RADIX_MIN) {
+        vec_introsort(vec->data, length, vec_sort_depth(length), NULL);
+        return 1;
+    }
+
+    // the unused part of the buffer is a free scratch buffer if it is big enough
+    if (vec->capacity - length >= length) {
+        vec_radix_sort(vec->data, vec->data + length, length);
+        return 1;
+    }
+
+    long *scratch = (long*)(vec_alloc(vec->allocator, length * sizeof (long)));
+
+    if (!scratch) {
+        // no memory left, but we can still sort in place
+        vec_introsort(vec->data, length, vec_sort_depth(length), NULL);
+        return 1;
+    }
+
+    vec_radix_sort(vec->data, scratch, length);
+    vec_free(vec->allocator, scratch, length * sizeof (long));
+
+    return 1;
+}
+
+short mc_vector_sort_by(vector vec, int (*compare)(long, long, void*), void *ctx) {
+    if (!vec || !compare) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    const vec_order order = { compare, ctx };
+
+    vec_introsort_by(vec->data, vec->count, vec_sort_depth(vec->count), &order);
+    return 1;
+}
+
+
+
+
+// Sorted vectors
+
+// Index of the first element which is not smaller than value (branchless: the loop only depends on length)
+static size_t vec_lower_bound(const long *data, size_t length, long value) {
+    if (length == 0)
+        return 0;
+
+    const long *base = data;
+
+    while (length > 1) {
+        const size_t half = length / 2;
+
+#if defined(__GNUC__)
+        // both possible next probes, so that the memory access is already on its way whatever the comparison says
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+#endif
+
+        base = (base[half] < value) ? base + half : base;
+        length -= half;
+    }
+
+    return (size_t)(base - data) + (*base < value);
+}
+
+// Checks and prepares dst to receive up to 'length' elements computed from a and b
+static short vec_prepare_output(vector dst, vector a, vector b, size_t length) {
+    if (!dst || !a || !b) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (dst == a || dst == b) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    dst->count = 0;
+
+    if (!vec_ensure_capacity(dst, length)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+size_t mc_vector_lower_bound(vector vec, long value) {
     if (!vec) {
         errno = EFAULT;
-        return LONG_MIN;
+        return 0;
     }
 
-    if (vec->count == 0) {
+    return vec_lower_bound(vec->data, vec->count, value);
+}
+
+short mc_vector_binary_search(vector vec, long value, size_t *index) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    const size_t pos = vec_lower_bound(vec->data, vec->count, value);
+
+    if (pos == vec->count || vec->data[pos] != value)
+        return 0;
+
+    if (index)
+        *index = pos;
+
+    return 1;
+}
+
+short mc_vector_insert_sorted_batch(vector vec, long *src, size_t length) {
+    if (!vec || !src) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (length == 0)
+        return 1;
+
+    if (!vec_ensure_capacity(vec, length)) {
         errno = ENOMEM;
-        return LONG_MIN;
+        return 0;
+    }
+
+    const long *batch = src;
+    long *copy = NULL;
+    size_t k = 1;
+
+    while (k < length && src[k - 1] <= src[k])
+        k++;
+
+    if (k < length) {
+        copy = (long*)(vec_alloc(vec->allocator, length * sizeof (long)));
+
+        if (!copy) {
+            errno = ENOMEM;
+            return 0;
+        }
+
+        memcpy(copy, src, length * sizeof (long));
+
+        // the room reserved for the batch is a free scratch buffer for the radix sort
+        if (length < MC_VECTOR_RADIX_MIN)
+            vec_introsort(copy, length, vec_sort_depth(length), NULL);
+        else
+            vec_radix_sort(copy, vec->data + vec->count, length);
+
+        batch = copy;
+    }
+
+    // backward merge: the element written last is never read again. Once the batch is exhausted, the remaining
+    // elements of the vector are already in place
+    long *data = vec->data;
+    size_t i = vec->count, j = length, w = vec->count + length;
+
+    while (i > 0 && j > 0) {
+        const short takeBatch = batch[j - 1] >= data[i - 1];
+
+        data[--w] = takeBatch ? batch[j - 1] : data[i - 1];
+        j -= takeBatch;
+        i -= !takeBatch;
+    }
+
+    memcpy(data, batch, j * sizeof (long));
+
+    VEC_STAT(vec, moved_bytes, (vec->count - i) * sizeof (long));
+    vec->count += length;
+
+    if (copy)
+        vec_free(vec->allocator, copy, length * sizeof (long));
+
+    VEC_STAT_PEAK(vec);
+    return 1;
+}
+
+size_t mc_vector_unique(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec->count < 2)
+        return 0;
+
+    if (!vec_writable(vec)) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    long *data = vec->data;
+    size_t write = 1;
+
+    for (size_t read = 1; read < vec->count; read++) {
+        // always store, only move the cursor forward for new values
+        data[write] = data[read];
+        write += data[read] != data[write - 1];
+    }
+
+    const size_t removed = vec->count - write;
+
+    vec->count = write;
+    return removed;
+}
+
+short mc_vector_merge(vector dst, vector a, vector b) {
+    if (!vec_prepare_output(dst, a, b, (a && b) ? a->count + b->count : 0))
+        return 0;
+
+    const long *x = a->data, *xend = a->data + a->count;
+    const long *y = b->data, *yend = b->data + b->count;
+    long *out = dst->data;
+
+    while (x != xend && y != yend) {
+        const short takeY = *y < *x;
+
+        *out++ = takeY ? *y : *x;
+        y += takeY;
+        x += !takeY;
+    }
+
+    memcpy(out, x, (size_t)(xend - x) * sizeof (long));
+    out += xend - x;
+    memcpy(out, y, (size_t)(yend - y) * sizeof (long));
+    out += yend - y;
+
+    dst->count = (size_t)(out - dst->data);
+    return 1;
+}
+
+short mc_vector_intersect(vector dst, vector a, vector b) {
+    if (!vec_prepare_output(dst, a, b, (a && b) ? min(a->count, b->count) : 0))
+        return 0;
+
+    const long *x = a->data, *xend = a->data + a->count;
+    const long *y = b->data, *yend = b->data + b->count;
+    long *out = dst->data;
+
+    while (x != xend && y != yend) {
+        const long vx = *x, vy = *y;
+
+        *out = vx;
+        out += vx == vy;
+        x += vx <= vy;
+        y += vy <= vx;
+    }
+
+    dst->count = (size_t)(out - dst->data);
+    return 1;
+}
+
+short mc_vector_difference(vector dst, vector a, vector b) {
+    if (!vec_prepare_output(dst, a, b, a ? a->count : 0))
+        return 0;
+
+    const long *x = a->data, *xend = a->data + a->count;
+    const long *y = b->data, *yend = b->data + b->count;
+    long *out = dst->data;
+
+    while (x != xend && y != yend) {
+        const long vx = *x, vy = *y;
+
+        *out = vx;
+        out += vx < vy;
+        x += vx <= vy;
+        y += vy <= vx;
+    }
+
+    memcpy(out, x, (size_t)(xend - x) * sizeof (long));
+    out += xend - x;
+
+    dst->count = (size_t)(out - dst->data);
+    return 1;
+}
+
+
+
+
+#ifndef MC_VECTOR_NO_IO
+
+// Text formatting. Integers are converted two digits at a time, and output goes through a writer which fills a buffer
+// and flushes it by large chunks
+
+static const char vec_digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// The longest representation of a long (sign and digits)
+#define VEC_LONG_CHARS (sizeof (long) * 3 + 2)
+
+// The size of the local buffer used by fprint and wprint
+#define VEC_CHUNK_SIZE 4096
+
+static size_t vec_count_digits(unsigned long x) {
+    size_t res = 1;
+
+    for (;;) {
+        if (x < 10)     return res;
+        if (x < 100)    return res + 1;
+        if (x < 1000)   return res + 2;
+        if (x < 10000)  return res + 3;
+
+        x /= 10000;
+        res += 4;
+    }
+}
+
+// Number of characters needed to print value
+static size_t vec_long_length(long value) {
+    const unsigned long magnitude = (value < 0) ? 0UL - (unsigned long)(value) : (unsigned long)(value);
+    return vec_count_digits(magnitude) + (value < 0);
+}
+
+// Writes value into out (which must hold at least VEC_LONG_CHARS characters), returns the number of characters written
+static size_t vec_format_long(char *out, long value) {
+    unsigned long x = (value < 0) ? 0UL - (unsigned long)(value) : (unsigned long)(value);
+    const size_t length = vec_count_digits(x) + (value < 0);
+    char *p = out + length;
+
+    while (x >= 100) {
+        const size_t pair = (size_t)(x % 100) * 2;
+        x /= 100;
+        *--p = vec_digit_pairs[pair + 1];
+        *--p = vec_digit_pairs[pair];
+    }
+
+    if (x >= 10) {
+        *--p = vec_digit_pairs[x * 2 + 1];
+        *--p = vec_digit_pairs[x * 2];
+    }
+    else {
+        *--p = (char)('0' + x);
+    }
+
+    if (value < 0)
+        *--p = '-';
+
+    return length;
+}
+
+static const char *vec_separator(vector_display option) {
+    return (option == VDisplay_SingleLine) ? ", "
+         : (option == VDisplay_OnePerLine) ? "\n"
+         : (" ");
+}
+
+
+typedef struct vec_writer_s {
+    char  *buf;                                 // Where characters are written
+    size_t len;                                 // The number of characters currently stored on buf
+    size_t cap;                                 // The capacity of buf
+    size_t total;                               // The number of characters already flushed
+    short  full;                                // Whether the output is full (nothing more can be written)
+
+    short (*flush)(struct vec_writer_s *w);     // Empties buf, NULL if buf is the final destination
+    void  *target;                              // The final destination (FILE* or wchar_t*)
+    size_t targetLen;                           // The number of characters that can still be written to target
+} vec_writer;
+
+static void vec_writer_flush(vec_writer *w) {
+    if (w->len == 0)
+        return;
+
+    if (!w->flush || !w->flush(w))
+        w->full = 1;
+}
+
+static void vec_write(vec_writer *w, const char *src, size_t length) {
+    while (length > 0 && !w->full) {
+        if (w->len == w->cap) {
+            vec_writer_flush(w);
+
+            if (w->full || w->len == w->cap) {
+                w->full = 1;
+                return;
+            }
+        }
+
+        const size_t n = min(length, w->cap - w->len);
+
+        memcpy(w->buf + w->len, src, n);
+        w->len += n;
+        src += n;
+        length -= n;
+    }
+}
+
+static void vec_write_long(vec_writer *w, long value) {
+    if (w->cap - w->len < VEC_LONG_CHARS && w->flush)
+        vec_writer_flush(w);
+
+    if (w->cap - w->len >= VEC_LONG_CHARS) {
+        // enough room, format in place
+        w->len += vec_format_long(w->buf + w->len, value);
+        return;
+    }
+
+    char temp[VEC_LONG_CHARS];
+    vec_write(w, temp, vec_format_long(temp, value));
+}
+
+static void vec_format(vec_writer *w, vector vec, vector_display option) {
+    const char *separator = vec_separator(option);
+    const size_t sepLen = strlen(separator);
+
+    if (option == VDisplay_SingleLine)
+        vec_write(w, "{", 1);
+
+    for (size_t i = 0; i < vec->count && !w->full; i++) {
+        vec_write_long(w, vec->data[i]);
+
+        if (i + 1 < vec->count)
+            vec_write(w, separator, sepLen);
+    }
+
+    if (option == VDisplay_SingleLine)
+        vec_write(w, "}", 1);
+
+    if (option != VDisplay_Raw)
+        vec_write(w, "\n", 1);
+
+    vec_writer_flush(w);
+}
+
+static short vec_flush_file(vec_writer *w) {
+    const size_t written = fwrite(w->buf, 1, w->len, (FILE*)(w->target));
+
+    w->total += written;
+    w->len = 0;
+
+    return written != 0;
+}
+
+static short vec_flush_wide(vec_writer *w) {
+    wchar_t *out = (wchar_t*)(w->target);
+    const size_t n = min(w->len, w->targetLen);
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = (wchar_t)(w->buf[i]);
+
+    w->target = out + n;
+    w->targetLen -= n;
+    w->total += n;
+    w->len = 0;
+
+    return n != 0;
+}
+
+
+size_t mc_vector_print_length(vector vec, vector_display option) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    size_t res = (option == VDisplay_SingleLine) ? 2 : 0;
+
+    if (option != VDisplay_Raw)
+        res++;
+
+    if (vec->count > 1)
+        res += (vec->count - 1) * strlen(vec_separator(option));
+
+    for (size_t i = 0; i < vec->count; i++)
+        res += vec_long_length(vec->data[i]);
+
+    return res;
+}
+
+int mc_vector_fprint(vector vec, FILE *stream, vector_display option) {
+    if (!vec || !stream) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    char chunk[VEC_CHUNK_SIZE];
+    vec_writer w = { chunk, 0, sizeof (chunk), 0, 0, vec_flush_file, stream, 0 };
+
+    vec_format(&w, vec, option);
+    return (int)(w.total);
+}
+
+int mc_vector_sprint(vector vec, char *buffer, int buflen, vector_display option) {
+    if (!vec || !buffer) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (buflen <= 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    // the string is the final destination, keep room for the null character
+    vec_writer w = { buffer, 0, (size_t)(buflen) - 1, 0, 0, NULL, NULL, 0 };
+
+    vec_format(&w, vec, option);
+    buffer[w.len] = '\0';
+
+    return (int)(w.len);
+}
+
+int mc_vector_wprint(vector vec, wchar_t *buffer, int buflen, vector_display option) {
+    if (!vec || !buffer) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (buflen <= 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    char chunk[VEC_CHUNK_SIZE];
+    vec_writer w = { chunk, 0, sizeof (chunk), 0, 0, vec_flush_wide, buffer, (size_t)(buflen) - 1 };
+
+    vec_format(&w, vec, option);
+    buffer[w.total] = L'\0';
+
+    return (int)(w.total);
+}
+
+
+
+// Binary format: a 16 bytes header followed by the raw elements
+//      - 4 bytes: magic "MCVB"
+//      - 1 byte : format version (MC_VECTOR_BINARY_VERSION)
+//      - 1 byte : element width in bytes (4 or 8)
+//      - 1 byte : byte order of the elements and of the count (1: little endian, 2: big endian)
+//      - 1 byte : reserved, 0
+//      - 8 bytes: number of elements
+// Elements start on an 8 bytes boundary, so that a mapped file can be used in place
+
+#define VEC_BIN_HEADER  16
+#define VEC_BIN_LITTLE  1
+#define VEC_BIN_BIG     2
+
+// The number of elements read at once by 'mc_vector_read_binary' when no conversion is needed
+#define VEC_BIN_BATCH   ((size_t)(1) << 20)
+
+static const unsigned char vec_bin_magic[4] = { 'M', 'C', 'V', 'B' };
+
+typedef struct {
+    unsigned char width;                    // The element width, in bytes
+    unsigned char order;                    // The byte order (VEC_BIN_LITTLE or VEC_BIN_BIG)
+    uint64_t      count;                    // The number of elements
+} vec_bin_header;
+
+static unsigned char vec_native_order(void) {
+    const uint16_t probe = 1;
+    return (*(const unsigned char*)(&probe) == 1) ? VEC_BIN_LITTLE : VEC_BIN_BIG;
+}
+
+// Decodes an unsigned integer of 'width' bytes stored in given byte order
+static uint64_t vec_bin_decode(const unsigned char *src, size_t width, unsigned char order) {
+    uint64_t res = 0;
+
+    for (size_t i = 0; i < width; i++) {
+        const size_t byte = (order == VEC_BIN_LITTLE) ? width - 1 - i : i;
+        res = (res << 8) | src[byte];
     }
 
-    long res = vec->data[--vec->count];
     return res;
 }
 
+static short vec_bin_parse(const unsigned char *src, vec_bin_header *out) {
+    if (memcmp(src, vec_bin_magic, sizeof (vec_bin_magic)) != 0 || src[4] != MC_VECTOR_BINARY_VERSION)
+        return 0;
 
+    out->width = src[5];
+    out->order = src[6];
 
-short mc_vector_insert(vector vec, size_t index, long value) {
-    if (!vec) {
-        errno = EFAULT;
+    if ((out->width != 4 && out->width != 8) || (out->order != VEC_BIN_LITTLE && out->order != VEC_BIN_BIG))
         return 0;
-    }
 
-    if (index >= vec->count) {
-        errno = EINVAL;
+    out->count = vec_bin_decode(src + 8, 8, out->order);
+    return 1;
+}
+
+// Converts a stored element to long, returns 0 if it does not fit
+static short vec_bin_element(const unsigned char *src, const vec_bin_header *header, long *out) {
+    const uint64_t raw = vec_bin_decode(src, header->width, header->order);
+    const int64_t value = (header->width == 4) ? (int64_t)(int32_t)(uint32_t)(raw) : (int64_t)(raw);
+
+    if (value < LONG_MIN || value > LONG_MAX)
         return 0;
-    }
 
-    if (!vec_ensure_capacity(vec, 1)) {
-        errno = ENOMEM;
+    *out = (long)(value);
+    return 1;
+}
+
+
+short mc_vector_write_binary(vector vec, FILE *stream) {
+    if (!vec || !stream) {
+        errno = EFAULT;
         return 0;
     }
 
-    if (index == vec->count-1)
-        return mc_vector_push(vec, value);
+    const unsigned char order = vec_native_order();
+    const uint64_t count = vec->count;
+    unsigned char header[VEC_BIN_HEADER] = { 0 };
 
-    memmove(vec->data + index + 1, vec->data + index, (vec->count - index) * sizeof (long));
+    memcpy(header, vec_bin_magic, sizeof (vec_bin_magic));
+    header[4] = MC_VECTOR_BINARY_VERSION;
+    header[5] = (unsigned char)(sizeof (long));
+    header[6] = order;
+    memcpy(header + 8, &count, sizeof (count));
 
-    vec->data[index] = value;
-    vec->count++;
+    if (fwrite(header, 1, sizeof (header), stream) != sizeof (header)
+        || fwrite(vec->data, sizeof (long), vec->count, stream) != vec->count) {
+        errno = EIO;
+        return 0;
+    }
 
     return 1;
 }
 
-short mc_vector_inserts(vector vec, size_t index, long *src, size_t length) {
-    if (!vec || !src) {
+vector mc_vector_read_binary(FILE *stream) {
+    if (!stream) {
         errno = EFAULT;
-        return 0;
+        return NULL;
+    }
+
+    unsigned char raw[VEC_BIN_HEADER];
+    vec_bin_header header;
+
+    if (fread(raw, 1, sizeof (raw), stream) != sizeof (raw)) {
+        errno = EIO;
+        return NULL;
     }
 
-    if (index >= vec->capacity || length == 0 || index + length >= vec->capacity) {
+    if (!vec_bin_parse(raw, &header)) {
         errno = EINVAL;
-        return 0;
+        return NULL;
     }
 
-    if (!vec_ensure_capacity(vec, length)) {
-        errno = ENOMEM;
-        return 0;
+    if (header.count > SIZE_MAX / sizeof (long)) {
+        errno = ENOBUFS;
+        return NULL;
     }
 
+    // the buffer grows while reading, so that a corrupted count fails on a truncated file rather than on allocation
+    const size_t count = (size_t)(header.count);
+    const short native = header.width == sizeof (long) && header.order == vec_native_order();
+    vector res = mc_vector_make((count > 0) ? min(count, VEC_BIN_BATCH) : 1);
 
-    if (index != vec->count-1) 
-        memmove(vec->data + index + length, vec->data + index, (vec->count - index) * sizeof (long));
+    if (!res)
+        return NULL;
 
-    memcpy(vec->data + index, src, length * sizeof (long));
+    unsigned char chunk[VEC_CHUNK_SIZE];
+    const size_t perChunk = sizeof (chunk) / header.width;
 
-    vec->count += length;
-    return length;
-}
+    while (res->count < count) {
+        const size_t n = min(native ? VEC_BIN_BATCH : perChunk, count - res->count);
 
+        if (!vec_ensure_capacity(res, n)) {
+            mc_vector_free(res);
+            errno = ENOBUFS;
+            return NULL;
+        }
 
+        if (native) {
+            // same layout as in memory, read straight into the buffer
+            if (fread(res->data + res->count, sizeof (long), n, stream) != n) {
+                mc_vector_free(res);
+                errno = EIO;
+                return NULL;
+            }
+        }
+        else {
+            if (fread(chunk, header.width, n, stream) != n) {
+                mc_vector_free(res);
+                errno = EIO;
+                return NULL;
+            }
 
+            for (size_t i = 0; i < n; i++) {
+                if (!vec_bin_element(chunk + i * header.width, &header, res->data + res->count + i)) {
+                    mc_vector_free(res);
+                    errno = ERANGE;
+                    return NULL;
+                }
+            }
+        }
 
-short mc_vector_remove(vector vec, size_t index) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+        res->count += n;
     }
 
-    if (index >= vec->count) {
-        errno = EINVAL;
-        return 0;
+    return res;
+}
+
+vector mc_vector_mmap(const char *path) {
+    if (!path) {
+        errno = EFAULT;
+        return NULL;
     }
 
-    if (index == vec->count-1)
-        return mc_vector_pop(vec) != LONG_MIN;
+#ifdef VEC_MMAP
+    const int fd = open(path, O_RDONLY);
 
-    memmove(vec->data + index, vec->data + index + 1, (vec->count - index) * sizeof (long));
-    vec->count--;
+    if (fd < 0)
+        return NULL;
 
-    return 1;
-}
+    struct stat st;
+    vec_bin_header header;
 
-short mc_vector_erase(vector vec, size_t index, size_t length) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
     }
 
-    if (index >= vec->count || length == 0 || index + length >= vec->count) {
+    if (st.st_size < VEC_BIN_HEADER || (uintmax_t)(st.st_size) > SIZE_MAX) {
+        close(fd);
         errno = EINVAL;
-        return 0;
+        return NULL;
     }
 
+    // private mapping: the file is never written, pages touched by the vector are copied on write
+    const size_t size = (size_t)(st.st_size);
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
 
-    memmove(vec->data + index, vec->data + index + length, (vec->count - index - length) * sizeof (long));
-
-    vec->count -= length;
-    return length;
-}
+    close(fd);
 
+    if (map == MAP_FAILED)
+        return NULL;
 
-short mc_vector_swap(vector vec1, vector vec2) {
-    if (!vec1 || !vec2) {
-        errno = EFAULT;
-        return 0;
+    if (!vec_bin_parse((const unsigned char*)(map), &header)
+        || header.width != sizeof (long) || header.order != vec_native_order()
+        || header.count > (size - VEC_BIN_HEADER) / sizeof (long)) {
+        munmap(map, size);
+        errno = EINVAL;
+        return NULL;
     }
 
-    size_t count = vec1->count;
-    size_t capacity = vec1->capacity;
-    long  *data = vec1->data;
+    vector res = (vector)(vec_alloc(NULL, sizeof (struct vector_s)));
 
-    vec1->count = vec2->count;
-    vec1->capacity = vec2->capacity;
-    vec1->data = vec2->data;
+    if (!res) {
+        munmap(map, size);
+        errno = ENOBUFS;
+        return NULL;
+    }
 
-    vec2->count = count;
-    vec2->capacity = capacity;
-    vec2->data = data;
+    res->count = (size_t)(header.count);
+    res->capacity = res->count;
+    res->data = (long*)((unsigned char*)(map) + VEC_BIN_HEADER);
+    res->heap_buf = NULL;
+    res->map = map;
+    res->mapsize = size;
+    res->allocator = NULL;
+    res->growth = VGrowth_Double;
+    res->align = vec_log2(MC_VECTOR_ALIGNMENT);
+    res->flags = 0;
+
+#ifdef MC_VECTOR_STATS
+    memset(&res->stats, 0, sizeof (vector_stats));
+#endif
+    res->bufsize = 0;
 
-    return 1;
+    return res;
+#else
+    errno = ENOSYS;
+    return NULL;
+#endif
 }
 
-short mc_vector_fill(vector vec, long value) {
-    return mc_vector_fill_range(vec, 0, vec->count, value);
-}
 
-short mc_vector_fill_range(vector vec, size_t index, size_t length, long value) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
-    }
 
-    if (index >= vec->count || length == 0 || index + length > vec->count) {
-        errno = EINVAL;
-        return 0;
-    }
+// Text parsing. Digits are converted 8 at a time (SWAR: the 8 characters are loaded in a 64-bit integer), input is
+// read through a reader which refills its buffer from the stream when needed
+
+// The size of the buffer used to read a stream
+#define VEC_PARSE_CHUNK 65536
+
+typedef struct {
+    const char *cur;                        // The next character to be read
+    const char *end;                        // The end of the available input
+    FILE  *stream;                          // The stream to read from, NULL if the whole input is available
+    char  *buf;                             // The buffer filled from the stream
+    size_t cap;                             // The size of buf
+} vec_reader;
+
+static const uint32_t vec_pow10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
 
-    // cannot use memset here since we use long :(
-    for (size_t i = index; i < index + length; i++) {
-        vec->data[i] = value;
+// Returns the number of available characters, reading the stream if less than 'need' are available
+static size_t vec_reader_avail(vec_reader *r, size_t need) {
+    size_t avail = (size_t)(r->end - r->cur);
+
+    if (avail < need && r->stream) {
+        memmove(r->buf, r->cur, avail);
+        avail += fread(r->buf + avail, 1, r->cap - avail, r->stream);
+
+        r->cur = r->buf;
+        r->end = r->buf + avail;
     }
 
-    return 1;
+    return avail;
+}
+
+static int vec_reader_peek(vec_reader *r) {
+    return vec_reader_avail(r, 1) ? (unsigned char)(*r->cur) : EOF;
 }
 
+// Loads 8 characters, the first one in the lowest byte
+static uint64_t vec_load8(const char *src) {
+    uint64_t x;
+    memcpy(&x, src, sizeof (x));
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
 
-short mc_vector_shrink(vector vec) {
-    return mc_vector_resize(vec, vec->count);
+    return x;
 }
 
-short mc_vector_resize(vector vec, size_t newSize) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
-    }
+// Number of leading digits of 8 loaded characters
+static size_t vec_digit_run(uint64_t x) {
+    const uint64_t high = 0x8080808080808080ULL;
+    const uint64_t low = x & ~high;
 
-    if (newSize == 0) {
-        errno = EINVAL;
-        return 0;
-    }
+    // a byte is a digit if it is below 0x80, at least '0' and at most '9'
+    const uint64_t ge0 = (low + 0x5050505050505050ULL) & high;
+    const uint64_t gt9 = (low + 0x4646464646464646ULL) & high;
+    const uint64_t nondigit = (x & high) | (ge0 ^ high) | gt9;
 
-    if (newSize <= MC_VECTOR_BUFSIZE) {
-        // new size is small enough to fit in the stack buffer
-        if (vec->data == vec->heap_buf) {
-            // we have to copy the content from the heap buffer and free it
-            memcpy(vec->stack_buf, vec->heap_buf, newSize * sizeof (long));
-            free(vec->heap_buf);
-            vec->heap_buf = NULL;
-        }
+    if (!nondigit)
+        return 8;
 
-        vec->data = vec->stack_buf;
-        vec->capacity = MC_VECTOR_BUFSIZE;
-        vec->count = newSize;
-    }
-    else {
-        // new size is too big for stack buffer
-        if (vec->data == vec->heap_buf) {
-            // we already have allocated a buffer, just realloc it
-            long *temp = (long*)realloc(vec->heap_buf, newSize * sizeof (long));
+#if defined(__GNUC__)
+    return (size_t)(__builtin_ctzll(nondigit)) / 8;
+#else
+    size_t res = 0;
 
-            if (!temp) {
-                errno = ENOMEM;
-                return 0;
-            }
+    while (!(nondigit & (0x80ULL << (res * 8))))
+        res++;
 
-            vec->heap_buf = temp;
+    return res;
+#endif
+}
+
+// Converts 8 loaded digits (the first one being the most significant)
+static uint32_t vec_convert8(uint64_t x) {
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return (uint32_t)(((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+
+// Parses an integer (optional sign followed by digits), returns 0 with errno set if there is none or if it does not
+// fit in a long
+static short vec_parse_long(vec_reader *r, long *out) {
+    int c = vec_reader_peek(r);
+    const short negative = (c == '-');
+
+    if (c == '-' || c == '+')
+        r->cur++;
+
+    const uint64_t limit = negative ? (uint64_t)(LONG_MAX) + 1 : (uint64_t)(LONG_MAX);
+    uint64_t value = 0;
+    size_t digits = 0;
+
+    for (;;) {
+        const size_t avail = vec_reader_avail(r, 8);
+        uint64_t x;
+
+        if (avail >= 8) {
+            x = vec_load8(r->cur);
         }
         else {
-            // we need to alloc a new buffer, and copy the content from the stack buffer
-            long *temp = (long*)(malloc(newSize * sizeof (long)));
+            // pad with null characters, which stop the run
+            char tail[8] = { 0 };
+            memcpy(tail, r->cur, avail);
+            x = vec_load8(tail);
+        }
 
-            if (!temp) {
-                errno = EINVAL;
-                return 0;
-            }
+        const size_t run = vec_digit_run(x);
 
-            memcpy(temp, vec->stack_buf, vec->count * sizeof (long));
-            vec->heap_buf = temp;
+        if (run == 0)
+            break;
+
+        // move the digits to the top, the bytes shifted in read as leading zeros
+        const uint32_t part = vec_convert8((run == 8) ? x : x << ((8 - run) * 8));
+
+        if (value > (limit - part) / vec_pow10[run]) {
+            errno = ERANGE;
+            return 0;
         }
 
-        // now update attributes
-        vec->data = vec->heap_buf;
-        vec->capacity = newSize;
+        value = value * vec_pow10[run] + part;
+        digits += run;
+        r->cur += run;
+
+        if (run < 8)
+            break;
+    }
+
+    if (digits == 0) {
+        errno = EINVAL;
+        return 0;
     }
 
+    *out = negative ? (long)(0 - value) : (long)(value);
     return 1;
 }
 
-short mc_vector_clear(vector vec) {
-    if (!vec) {
-        errno = EFAULT;
-        return 0;
-    }
+static void vec_skip(vec_reader *r, const char *set) {
+    int c;
 
-    if (vec->data == vec->heap_buf) {
-        // free the buffer
-        free(vec->heap_buf);
-        vec->heap_buf = NULL;
-        vec->data = vec->stack_buf;
-        vec->capacity = MC_VECTOR_BUFSIZE;
-    }
+    while ((c = vec_reader_peek(r)) != EOF && c != '\0' && strchr(set, c))
+        r->cur++;
+}
 
-    vec->count = 0;
+// Appends an element, growing the vector like push does
+static short vec_parse_push(vector vec, long value) {
+    if (vec->count == vec->capacity && !vec_ensure_capacity(vec, 1))
+        return 0;
+
+    vec->data[vec->count++] = value;
     return 1;
 }
 
+#define VEC_SPACES  " \t\r\n\v\f"
+#define VEC_BLANKS  " \t\r\v\f"
 
+// Parses the whole input into vec, returns 0 with errno set on failure
+static short vec_parse(vec_reader *r, vector vec, vector_display option) {
+    short done = 0;
+    long  value;
+    int   c;
 
+    vec_skip(r, VEC_SPACES);
 
-#ifndef MC_VECTOR_NO_IO
+    if (option == VDisplay_SingleLine) {
+        if (vec_reader_peek(r) != '{') {
+            errno = EINVAL;
+            return 0;
+        }
 
-int mc_vector_fprint(vector vec, FILE *stream, vector_display option) {
-    if (!vec || !stream) {
-        errno = EFAULT;
-        return 0;
+        r->cur++;
+        vec_skip(r, VEC_SPACES);
     }
 
-    int res = 0;
+    while ((c = vec_reader_peek(r)) != EOF) {
+        if (option == VDisplay_SingleLine && c == '}' && vec->count == 0)
+            break;
 
-    const char *separator = (option == VDisplay_SingleLine) ? ", "
-                          : (option == VDisplay_OnePerLine) ? "\n"
-                          : (" ");
+        if (!vec_parse_long(r, &value))
+            return 0;
 
-    if (option == VDisplay_SingleLine)
-        res += fprintf(stream, "{", sizeof (char));
+        if (!vec_parse_push(vec, value)) {
+            errno = ENOBUFS;
+            return 0;
+        }
 
-    for (size_t i = 0; i < vec->count; i++) {
-        res += fprintf(stream, "%lu", vec->data[i], sizeof (long));
+        // consume the separator following the element
+        switch (option) {
+            case VDisplay_SingleLine:
+                vec_skip(r, VEC_SPACES);
+                c = vec_reader_peek(r);
 
-        if (i + 1 < vec->count)
-            res += fprintf(stream, "%s", separator, sizeof (separator));
-    }
+                if (c != ',' && c != '}') {
+                    errno = EINVAL;
+                    return 0;
+                }
 
-    if (option == VDisplay_SingleLine)
-        res += fprintf(stream, "}", sizeof (char));
+                if (c == '}')
+                    done = 1;
 
-    if (option != VDisplay_Raw)
-        res += fprintf(stream, "\n", sizeof (char));
+                r->cur += (c == ',');
+                vec_skip(r, VEC_SPACES);
+                break;
 
-    return res;
-}
+            case VDisplay_OnePerLine:
+                vec_skip(r, VEC_BLANKS);
+                c = vec_reader_peek(r);
 
-int mc_vector_sprint(vector vec, char *buffer, int buflen, vector_display option) {
-    if (!vec || !buffer) {
-        errno = EFAULT;
-        return 0;
-    }
+                if (c != '\n' && c != EOF) {
+                    errno = EINVAL;
+                    return 0;
+                }
 
-    if (buflen <= 0) {
-        errno = EINVAL;
-        return 0;
-    }
+                vec_skip(r, VEC_SPACES);
+                break;
 
-    int temp, res = 0;
-    const char *separator = (option == VDisplay_SingleLine) ? ", "
-                          : (option == VDisplay_OnePerLine) ? "\n"
-                          : (" ");
+            default:
+                c = vec_reader_peek(r);
 
+                if (c != EOF && c != ',' && !strchr(VEC_SPACES, c)) {
+                    errno = EINVAL;
+                    return 0;
+                }
 
-    if (option == VDisplay_SingleLine) {
-        temp = sprintf(buffer, buflen, "{");
-        res += temp;
-        buffer += temp;
-        buflen -= temp;
-    }
+                vec_skip(r, VEC_SPACES);
 
-    for (size_t i = 0; i < vec->count && buflen > 0; i++) {
-        temp = sprintf(buffer, buflen, "%lu", vec->data[i]);
+                if (vec_reader_peek(r) == ',') {
+                    r->cur++;
+                    vec_skip(r, VEC_SPACES);
+                }
+                break;
+        }
 
-        res += temp;
-        buffer += temp;
-        buflen -= temp;
+        if (done)
+            break;
+    }
 
-        if (buflen > 0 && i + 1 < vec->count) {
-            temp = sprintf(buffer, buflen, "%s", separator);
-            res += temp;
-            buffer += temp;
-            buflen -= temp;
+    if (option == VDisplay_SingleLine) {
+        if (vec_reader_peek(r) != '}') {
+            errno = EINVAL;
+            return 0;
         }
+
+        r->cur++;
+        vec_skip(r, VEC_SPACES);
     }
 
-    if (buflen >= 0 && option == VDisplay_SingleLine) {
-        temp = sprintf(buffer, buflen, "}");
-        res += temp;
-        buflen += temp;
-        buffer += temp;
+    if (vec_reader_peek(r) != EOF) {
+        errno = EINVAL;
+        return 0;
     }
 
-    if (buflen >= 0 && option != VDisplay_Raw) {
-        temp = sprintf(buffer, buflen, "\n");
-        res += temp;
+    if (r->stream && ferror(r->stream)) {
+        errno = EIO;
+        return 0;
     }
 
-    return res;
+    return 1;
 }
 
 
-int mc_vector_wprint(vector vec, wchar_t *buffer, int buflen, vector_display option) {
-    if (!vec || !buffer) {
+vector mc_vector_parse(const char *buffer, size_t length, vector_display option) {
+    if (!buffer) {
         errno = EFAULT;
-        return 0;
+        return NULL;
     }
 
-    if (buflen <= 0) {
-        errno = EINVAL;
-        return 0;
-    }
+    // a guess of 8 characters per element (digits and separator), the vector grows if they are shorter. Sizing from
+    // the worst case (2 characters) would allocate 4 times too much for typical input
+    vector res = mc_vector_make(length / 8 + 1);
 
-    int temp, res = 0;
-    const wchar_t *separator = (option == VDisplay_SingleLine) ? L", "
-                          : (option == VDisplay_OnePerLine) ? L"\n"
-                          : (L" ");
+    if (!res)
+        return NULL;
 
+    vec_reader r = { buffer, buffer + length, NULL, NULL, 0 };
 
-    if (option == VDisplay_SingleLine) {
-        temp = swprintf(buffer, buflen, L"{");
-        res += temp;
-        buffer += temp;
-        buflen -= temp;
+    if (!vec_parse(&r, res, option)) {
+        mc_vector_free(res);
+        return NULL;
     }
 
-    for (size_t i = 0; i < vec->count && buflen > 0; i++) {
-        temp = swprintf(buffer, buflen, L"%lu", vec->data[i]);
-
-        res += temp;
-        buffer += temp;
-        buflen -= temp;
+    return res;
+}
 
-        if (buflen > 0 && i + 1 < vec->count) {
-            temp = swprintf(buffer, buflen, L"%s", separator);
-            res += temp;
-            buffer += temp;
-            buflen -= temp;
-        }
+vector mc_vector_fparse(FILE *stream, vector_display option) {
+    if (!stream) {
+        errno = EFAULT;
+        return NULL;
     }
 
-    if (buflen >= 0 && option == VDisplay_SingleLine) {
-        temp = swprintf(buffer, buflen, L"}");
-        res += temp;
-        buflen += temp;
-        buffer += temp;
+    char *chunk = (char*)(malloc(VEC_PARSE_CHUNK));
+    vector res = mc_vector_make(VEC_PARSE_CHUNK / 8);
+
+    if (!chunk || !res) {
+        free(chunk);
+        mc_vector_free(res);
+        errno = ENOBUFS;
+        return NULL;
     }
 
-    if (buflen >= 0 && option != VDisplay_Raw) {
-        temp = swprintf(buffer, buflen, L"\n");
-        res += temp;
+    vec_reader r = { chunk, chunk, stream, chunk, VEC_PARSE_CHUNK };
+
+    if (!vec_parse(&r, res, option)) {
+        mc_vector_free(res);
+        res = NULL;
     }
 
+    free(chunk);
     return res;
 }
 
 
 
-#endif 
\ No newline at end of file
+#endif
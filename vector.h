@@ -5,21 +5,21 @@
  * 
  * @brief  A small library for manipulating dynamically allocated arrays (vector).
  *         Vector are constructed using small buffer optimization. An initial buffer is allocated on the stack, its size is defined
- *         by the macro 'MC_VECTOR_BUFSIZE'. If we need more memory than we got on the stack, then a new buffer will be allocated
- *         on the heap. This means that the vector's capacity can be increased or decreased at runtime. Note however than a vector
- *         capacity cannot be smaller than 'MC_VECTOR_BUFSIZE', since we will go back to the stack buffer if capacity is decreased
- *         such that it can fit on the stack.
+ *         by the macro 'MC_VECTOR_BUFSIZE' (or chosen per vector, see 'mc_vector_make_sbo'). If we need more memory than we got
+ *         on the stack, then a new buffer will be allocated on the heap. This means that the vector's capacity can be increased
+ *         or decreased at runtime. Note however than a vector capacity cannot be smaller than its stack buffer size, since we
+ *         will go back to the stack buffer if capacity is decreased such that it can fit on the stack.
  *         Memory management is handled automatically by the API, but some functions can be used to manually increase or decrease
  *         the vector's capacity (such as 'resize' or 'shrink').
  *         The vector type is a typedef for a pointer to an opaque struct. This means user cannot access the content of the vector
- *         without using API's function, and that vector are passed by reference by default (this behavior can however be bypassed
- *         by using 'struct vector_s' instead of 'vector', but it is not recommended).  
+ *         without using API's function, and that vector are passed by reference by default. Since the stack buffer is stored at
+ *         the end of the struct and sized at creation, 'struct vector_s' cannot be used by value.  
  *         The api provides several function to create and destroy a vector, and to manipulate its content (inserting / removing /
  *         accessing elements). 
  * 
  *         !!!!!!!!!!!!! NOTE THAT SINCE 'VECTOR' IS A POINTER, YOU [[HAVE TO]] DEALLOCATE THEM TO AVOID MEMORY LEAKS !!!!!!!!!!!!!      
  *    
- * @version 1.3
+ * @version 1.4
  * 
  * @date 2022-08-17
  * 
@@ -37,6 +37,53 @@ versions update:
               'mc_vector_resize' and make 'mc_vector_shrink' just call it, remove 'mc_pop_several' and 'mc_push_several',
               add 'mc_vector_wprint', use 'fprintf_s' and 'sprintf_s' instead of 'fprintf' and 'sprintf' on _WIN32 platform,
               rewrite documentation.
+    1.4     - add MC_VECTOR_INLINE guard, exposing the struct layout and unchecked 'static inline' accessors.
+            - add 'mc_vector_data' and 'mc_vector_span' (borrowed views), use memcpy in 'mc_vector_extract'.
+            - add 'vector_generic.h' (vectors of any element type), declare the API with C linkage in C++.
+            - add 'mc_vector_make_sbo' and 'mc_vector_bufsize', the stack buffer is now a trailing array sized
+              at creation.
+            - add 'mc_vector_make_block', 'mc_vector_push_block' and 'mc_vector_reserve_block' (single-allocation
+              vectors, grown by reallocating the whole block).
+            - add 'mc_vector_make_with' and 'allocator.h' (custom allocators, bump arena and fixed-size pool).
+            - add 'mc_vector_reserve' and 'mc_vector_set_growth' (growth policies), grow only when the buffer is
+              actually full, make 'mc_vector_resize' keep the size of the vector when it fits in the new buffer.
+            - add 'mc_vector_append', 'mc_vector_append_vector' and 'mc_vector_push_n', make 'mc_vector_inserts'
+              check its index against the size of the vector (so that it can append).
+            - use SIMD kernels (selected at runtime) in fill functions, memset / calloc for zero fills.
+            - add reductions: 'mc_vector_sum', 'mc_vector_min', 'mc_vector_max', 'mc_vector_minmax', 'mc_vector_dot'
+              and their overflow-checked variants.
+            - add 'mc_vector_sort' (radix sort, introsort for small vectors) and 'mc_vector_sort_by'.
+            - add functions on sorted vectors: 'mc_vector_lower_bound', 'mc_vector_binary_search', 'mc_vector_unique',
+              'mc_vector_merge', 'mc_vector_intersect' and 'mc_vector_difference'.
+            - add 'mc_vector_swap_remove', 'mc_vector_remove_if' and 'mc_vector_retain', fix 'mc_vector_remove'
+              moving one element too many, let 'mc_vector_erase' remove a range ending at the last element.
+            - rewrite print functions without printf (two digits per step conversion, output written by chunks),
+              print elements as signed integers, add 'mc_vector_print_length'.
+            - add binary serialization ('mc_vector_write_binary', 'mc_vector_read_binary') and 'mc_vector_mmap'
+              (vectors loaded in place from a mapped file).
+            - add 'mc_vector_parse' and 'mc_vector_fparse', reading back the three display formats (SWAR integer
+              parsing, 8 digits per step).
+            - align heap buffers on a cache line by default, add 'mc_vector_set_alignment' and 'mc_vector_alignment'
+              (growth allocates an aligned buffer and copies the elements instead of calling realloc).
+            - map large heap buffers from the system (huge pages, grown with mremap), give their pages back on
+              'mc_vector_clear' and 'mc_vector_shrink'.
+            - add 'cvector.h' (concurrent vector: lock-free appends on segments which are never moved).
+            - add 'vector_parallel.h' (opt-in multithreaded fill, transform, reductions and radix sort).
+            - add 'mc_vector_adopt', 'mc_vector_release' and 'mc_vector_move' (buffers passed around without copying),
+              allocate aligned heap buffers with posix_memalign where it exists.
+            - fix 'mc_vector_swap' on vectors using their stack buffer (heap buffers are exchanged, inline elements
+              are copied), add 'mc_vector_move_assign'.
+            - add MC_VECTOR_CACHE (per-thread cache of headers and small heap buffers), 'mc_vector_cache_stats' and
+              'mc_vector_cache_flush'.
+            - add 'mc_vector_begin', 'mc_vector_end', MC_VECTOR_FOREACH, 'mc_vector_for_each' and
+              'mc_vector_transform'.
+            - add 'svector.h' (segmented vector: appends never move elements, contiguous spans per segment).
+            - add 'pvector.h' (frozen compressed vectors: delta encoding, bit-packed blocks with exceptions).
+            - add a Makefile (static library) and micro-benchmarks ('bench/'), against raw arrays and std::vector.
+            - add MC_VECTOR_STATS (reallocation, spill, moved bytes, peak and live heap counters),
+              'mc_vector_stats_snapshot', 'mc_vector_stats' and 'mc_vector_stats_reset'.
+            - add 'mc_vector_insert_sorted_batch' (single pass merge), 'mc_vector_gather' and 'mc_vector_scatter'.
+            - add copy-on-write vectors: 'mc_vector_share', 'mc_vector_unshare' and 'mc_vector_is_shared'.
 */
 
 
@@ -46,6 +93,10 @@ versions update:
  * 
  * By default, this header defines some helper macros, as shortcuts to the long-full-name of each functions. To disable this,
  * define MC_VECTOR_NO_MACROS [[BEFORE]] including this file.
+ * 
+ * By default, 'struct vector_s' is opaque and every access goes through an out-of-line, checked function. To get
+ * the struct layout and 'static inline' unchecked accessors (see the end of this file), define MC_VECTOR_INLINE
+ * [[BEFORE]] including this file. The checked API stays available in both modes.
  */
 
 #ifndef MC_VECTOR_H
@@ -53,28 +104,86 @@ versions update:
 
 #include <stddef.h>
 
+#include "allocator.h"
+
 #ifndef MC_VECTOR_NO_IO
 #   include <stdio.h>
 #endif 
 
-#define MC_VECTOR_BUFSIZE 10
+#ifndef MC_VECTOR_BUFSIZE
+#   define MC_VECTOR_BUFSIZE 10
+#endif
+
+#ifndef MC_VECTOR_PAGESIZE
+#   define MC_VECTOR_PAGESIZE 4096
+#endif
+
+// The default alignment of heap buffers (a cache line), see 'mc_vector_set_alignment'
+#ifndef MC_VECTOR_ALIGNMENT
+#   define MC_VECTOR_ALIGNMENT 64
+#endif
+
+// The biggest alignment which can be asked for a heap buffer (a huge page)
+#ifndef MC_VECTOR_MAX_ALIGNMENT
+#   define MC_VECTOR_MAX_ALIGNMENT (2 << 20)
+#endif
+
+// Heap buffers of at least this many bytes (with the standard allocator) are mapped directly from the system, on
+// platforms which have mmap. Define MC_VECTOR_HUGETLB to ask for explicit huge pages (which must be reserved)
+#ifndef MC_VECTOR_MMAP_THRESHOLD
+#   define MC_VECTOR_MMAP_THRESHOLD (32 << 20)
+#endif
+
+// Define MC_VECTOR_CACHE to keep, per thread, the headers and small heap buffers of destroyed vectors (standard
+// allocator only), and give them back to the next vectors created by this thread instead of calling malloc
+#ifndef MC_VECTOR_CACHE_HEADERS
+#   define MC_VECTOR_CACHE_HEADERS 64       // The number of headers kept per thread
+#endif
+
+#ifndef MC_VECTOR_CACHE_BUFFERS
+#   define MC_VECTOR_CACHE_BUFFERS 8        // The number of heap buffers kept per thread and per size class
+#endif
+
+#ifndef MC_VECTOR_CACHE_MAX_BUFFER
+#   define MC_VECTOR_CACHE_MAX_BUFFER (64 << 10)   // Bigger heap buffers (in bytes) are never kept
+#endif
+
+// Define MC_VECTOR_STATS (when building the library and every file using MC_VECTOR_INLINE, since it changes the
+// struct layout) to count reallocations, spills and moved bytes, see 'mc_vector_stats_snapshot'. Without it, counters
+// compile to nothing
 
 #ifndef MC_VECTOR_NO_MACROS
 
 #define vec()                               mc_vector_make(MC_VECTOR_BUFSIZE)
 #define vmake(capacity)                     mc_vector_make(capacity)
+#define vmakesbo(capacity, bufsize)         mc_vector_make_sbo(capacity, bufsize)
+#define vmakeb(capacity)                    mc_vector_make_block(capacity)
+#define vmakew(capacity, bufsize, alloc)    mc_vector_make_with(capacity, bufsize, alloc)
 #define vmakef(capacity, length, value)     mc_vector_make_filled(capacity, length, value)
 #define vclone(vec)                         mc_vector_clone(vec)
+#define vshare(vec)                         mc_vector_share(vec)
+#define vunshare(vec)                       mc_vector_unshare(vec)
 #define varray(src, len)                    mc_vector_from_array(src, len)
+#define vadopt(buffer, len, cap)            mc_vector_adopt(buffer, len, cap)
+#define vmove(vec)                          mc_vector_move(vec)
 #define vfree(vec)                          mc_vector_free(vec)
 
 #define vtoarr(vec, buffer)                 mc_vector_to_array(vec, buffer)
 #define vextract(vec, buffer, index, len)   mc_vector_extract(vec, buffer, index, len)
+#define vrelease(vec, outLen)               mc_vector_release(vec, outLen)
+#define vdata(vec)                          mc_vector_data(vec)
+#define vspan(vec)                          mc_vector_span(vec)
+#define vbegin(vec)                         mc_vector_begin(vec)
+#define vend(vec)                           mc_vector_end(vec)
+#define vforeach(vec, fn, ctx)              mc_vector_for_each(vec, fn, ctx)
+#define vtransform(vec, fn, ctx)            mc_vector_transform(vec, fn, ctx)
 
 #define vget(vec, index, out)               mc_vector_get(vec, index, out)
 #define vgetu(vec, index)                   mc_vector_get_unchecked(vec, index)
 #define vset(vec, index, value)             mc_vector_set(vec, index, value)
 #define vstack(vec)                         mc_vector_is_stack(vec)
+#define vshared(vec)                        mc_vector_is_shared(vec)
+#define vbufsize(vec)                       mc_vector_bufsize(vec)
 
 #define vsize(vec)                          mc_vector_size(vec)
 #define vcapacity(vec)                      mc_vector_capacity(vec)
@@ -82,21 +191,60 @@ versions update:
 
 #define vpush(vec, value)                   mc_vector_push(vec, value)
 #define vpop(vec)                           mc_vector_pop(vec)
+#define vappend(vec, src, len)              mc_vector_append(vec, src, len)
+#define vappendv(dst, src)                  mc_vector_append_vector(dst, src)
+#define vpushn(vec, value, len)             mc_vector_push_n(vec, value, len)
+#define vpushb(pvec, value)                 mc_vector_push_block(pvec, value)
+#define vreserveb(pvec, capacity)           mc_vector_reserve_block(pvec, capacity)
 
 #define vinsert(vec, index, value)          mc_vector_insert(vec, index, value)
 #define vinserts(vec, index, src, len)      mc_vector_inserts(vec, index, src, len)
 
 #define vremove(vec, index)                 mc_vector_remove(vec, index)
 #define verase(vec, index, length)          mc_vector_erase(vec, index, length)
+#define vswapremove(vec, index)             mc_vector_swap_remove(vec, index)
+#define vremoveif(vec, pred, ctx)           mc_vector_remove_if(vec, pred, ctx)
+#define vretain(vec, pred, ctx)             mc_vector_retain(vec, pred, ctx)
 
 #define vswap(v1, v2)                       mc_vector_swap(v1, v2)
+#define vmoveto(dst, src)                   mc_vector_move_assign(dst, src)
 #define vfill(vec, value)                   mc_vector_fill(vec, value)
 #define vfillr(vec, index, length, value)   mc_vector_fill_range(vec, index, length, value)
 
 #define vshrink(vec)                        mc_vector_shrink(vec)
 #define vresize(vec, newSize)               mc_vector_resize(vec, newSize)
+#define vreserve(vec, length)               mc_vector_reserve(vec, length)
+#define vgrowth(vec, policy)                mc_vector_set_growth(vec, policy)
+#define valign(vec, alignment)              mc_vector_set_alignment(vec, alignment)
+#define valignment(vec)                     mc_vector_alignment(vec)
 #define vclear(vec)                         mc_vector_clear(vec)
 
+#define vcachestats(out)                    mc_vector_cache_stats(out)
+#define vcacheflush()                       mc_vector_cache_flush()
+#define vstatsall()                         mc_vector_stats_snapshot()
+#define vstats(vec, out)                    mc_vector_stats(vec, out)
+#define vstatsreset()                       mc_vector_stats_reset()
+
+#define vsum(vec, out)                      mc_vector_sum(vec, out)
+#define vmin(vec, out)                      mc_vector_min(vec, out)
+#define vmax(vec, out)                      mc_vector_max(vec, out)
+#define vminmax(vec, outMin, outMax)        mc_vector_minmax(vec, outMin, outMax)
+#define vdot(v1, v2, out)                   mc_vector_dot(v1, v2, out)
+
+#define vgather(vec, indices, out)          mc_vector_gather(vec, indices, out)
+#define vscatter(vec, indices, values)      mc_vector_scatter(vec, indices, values)
+
+#define vsort(vec)                          mc_vector_sort(vec)
+#define vsortby(vec, compare, ctx)          mc_vector_sort_by(vec, compare, ctx)
+
+#define vlbound(vec, value)                 mc_vector_lower_bound(vec, value)
+#define vbsearch(vec, value, index)         mc_vector_binary_search(vec, value, index)
+#define vinsertsorted(vec, src, len)        mc_vector_insert_sorted_batch(vec, src, len)
+#define vunique(vec)                        mc_vector_unique(vec)
+#define vmerge(dst, a, b)                   mc_vector_merge(dst, a, b)
+#define vintersect(dst, a, b)               mc_vector_intersect(dst, a, b)
+#define vdifference(dst, a, b)              mc_vector_difference(dst, a, b)
+
 #ifndef MC_VECTOR_NO_IO
 
 #define vfprint(vec, stream)                mc_vector_fprint(vec, stream, VDisplay_SingleLine)
@@ -108,15 +256,99 @@ versions update:
 #define vwprint2(vec, buf, buflen, option)  mc_vector_wprint(vec, buf, buflen, option)
 
 #define vprint(vec)                         mc_vector_fprint(vec, stdout, VDisplay_SingleLine)
+#define vprintlen(vec, option)              mc_vector_print_length(vec, option)
+
+#define vparse(buf, buflen)                 mc_vector_parse(buf, buflen, VDisplay_SingleLine)
+#define vfparse(stream)                     mc_vector_fparse(stream, VDisplay_SingleLine)
+#define vparse2(buf, buflen, option)        mc_vector_parse(buf, buflen, option)
+#define vfparse2(stream, option)            mc_vector_fparse(stream, option)
+
+#define vwriteb(vec, stream)                mc_vector_write_binary(vec, stream)
+#define vreadb(stream)                      mc_vector_read_binary(stream)
+#define vmmap(path)                         mc_vector_mmap(path)
 
 #endif /* MC_VECTOR_NO_IO */
 
+#ifdef MC_VECTOR_INLINE
+
+#define vfget(vec, index)                   mc_vector_get_fast(vec, index)
+#define vfset(vec, index, value)            mc_vector_set_fast(vec, index, value)
+#define vfpush(vec, value)                  mc_vector_push_fast(vec, value)
+#define vfpop(vec)                          mc_vector_pop_fast(vec)
+#define vfforeach(vec, fn, ctx)             mc_vector_for_each_fast(vec, fn, ctx)
+
+#endif /* MC_VECTOR_INLINE */
+
 #endif /* MC_VECTOR_NO_MACROS */
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Forward declaration of the vector struct
 typedef struct vector_s * vector;
 
+// A borrowed, read-only view over the content of a vector
+typedef struct {
+    const long *data;                       // A pointer to the first element
+    size_t      length;                     // The number of elements in the view
+} vector_span;
+
+typedef enum {
+    VGrowth_Double          = 0x0000,   // Doubles the capacity (default)
+    VGrowth_OneAndHalf      = 0x0001,   // Multiplies the capacity by 1.5, trading more reallocations for less unused memory
+    VGrowth_Page            = 0x0002    // Like VGrowth_OneAndHalf, but buffers bigger than a page are rounded up to
+                                        // a whole number of pages (see MC_VECTOR_PAGESIZE)
+} vector_growth;
+
+// The counters of MC_VECTOR_STATS, for the whole library or for a single vector
+typedef struct {
+    size_t reallocations;                   // Heap buffers moved to another buffer (growth, resize, alignment)
+    size_t spills;                          // Moves from the stack buffer to a heap buffer
+    size_t moved_bytes;                     // Bytes moved by insert, remove and erase
+    size_t peak_capacity;                   // The biggest capacity (of any vector, for the library)
+    size_t peak_count;                      // The biggest number of elements (of any vector, for the library)
+    size_t live_heap_bytes;                 // The size of the heap buffers currently allocated
+} vector_stats;
+
+// The counters of the allocation cache of a thread (see MC_VECTOR_CACHE)
+typedef struct {
+    size_t header_hits;                     // Headers taken from the cache
+    size_t header_misses;                   // Headers allocated because the cache was empty
+    size_t buffer_hits;                     // Heap buffers taken from the cache
+    size_t buffer_misses;                   // Heap buffers allocated because no cached buffer was big enough
+} vector_cache_stats;
+
+
+#if defined(MC_VECTOR_INLINE) || defined(MC_VECTOR_IMPLEMENTATION)
+
+struct vector_s {
+    size_t count;                           // The number of element currently stored on the vector
+    size_t capacity;                        // The total capacity of the vector
+
+    long  *data;                            // A pointer to the currently used buffer (stack_buf or heap_buf)
+    long  *heap_buf;                        // A pointer to a buffer allocated on the heap, if needed
+    void  *map;                             // The file mapping (see mc_vector_mmap) or the shared buffer (see
+                                            // mc_vector_share) data points into, NULL otherwise
+    size_t mapsize;                         // The size of the file mapping, in bytes
+
+    const mc_allocator *allocator;          // The allocator used by the vector, NULL for the standard malloc / free
+    unsigned char growth;                   // The growth policy of the vector (see vector_growth)
+    unsigned char align;                    // The alignment of heap_buf, as a power of two (log2)
+    unsigned char flags;                    // How heap_buf was obtained (adopted from the caller or not), and
+                                            // whether data is shared
+
+#ifdef MC_VECTOR_STATS
+    vector_stats stats;                     // The counters of this vector (live_heap_bytes is not used)
+#endif
+
+    size_t bufsize;                         // The number of elements that fit in stack_buf
+    long   stack_buf[];                     // A buffer allocated along with the vector, sized at creation
+};
+
+#endif /* MC_VECTOR_INLINE || MC_VECTOR_IMPLEMENTATION */
+
 
 
 
@@ -133,6 +365,57 @@ typedef struct vector_s * vector;
  */
 vector mc_vector_make(size_t capacity);
 
+/**
+ * @brief Creates a new vector, with given capacity and a stack buffer of given size. 'mc_vector_make' is equivalent
+ *        to calling this function with MC_VECTOR_BUFSIZE as bufsize. A small bufsize reduces the memory footprint
+ *        of vectors that hold very few elements, while a bufsize of 0 avoids wasting memory on vectors that will 
+ *        always live on the heap.
+ * 
+ * @param[in] capacity  The capacity of the resulting vector
+ * @param[in] bufsize   The number of elements that can be stored without allocating a heap buffer
+ *  
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   If given capacity is not valid (i.e capacity == 0), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS 
+ */
+vector mc_vector_make_sbo(size_t capacity, size_t bufsize);
+
+/**
+ * @brief Creates a new vector, with given capacity and stack buffer size, whose memory (the vector itself and its heap
+ *        buffer) is managed by a given allocator. Every vector created from this one (by 'mc_vector_clone') uses the
+ *        same allocator.
+ * 
+ * @param[in] capacity   The capacity of the resulting vector
+ * @param[in] bufsize    The number of elements that can be stored without allocating a heap buffer
+ * @param[in] allocator  The allocator to be used, or NULL for the standard malloc / realloc / free. It is not copied,
+ *                       and must outlive the vector.
+ *  
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   If given capacity is not valid (i.e capacity == 0), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ *         When using an arena, vectors don't need to be freed one by one: 'mc_arena_reset' releases every one
+ *           of them at once (after what they must not be used anymore, nor freed).
+ */
+vector mc_vector_make_with(size_t capacity, size_t bufsize, const mc_allocator *allocator);
+
+/**
+ * @brief Creates a new vector whose elements are stored in the same allocation as the vector itself (its stack buffer
+ *        is as large as the requested capacity). This costs a single allocation, and the first elements share a
+ *        cache line with the vector's attributes. Such a vector can be used with every function of this API, but 
+ *        'mc_vector_push_block' and 'mc_vector_reserve_block' must be used to keep it in a single allocation when it
+ *        grows.
+ * 
+ * @param[in] capacity  The capacity of the resulting vector
+ *  
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   If given capacity is not valid (i.e capacity == 0), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS 
+ */
+vector mc_vector_make_block(size_t capacity);
+
 /**
  * @brief Creates a new vector, filled with a given value
  * 
@@ -148,7 +431,8 @@ vector mc_vector_make(size_t capacity);
 vector mc_vector_make_filled(size_t capacity, size_t length, long value);
 
 /**
- * @brief Creates a copy of a given vector
+ * @brief Creates a copy of a given vector. If the vector shares its buffer (see 'mc_vector_share'), the copy shares
+ *        it as well, and nothing is copied.
  * 
  * @param[in] vec  The vector to be cloned
  * 
@@ -159,6 +443,42 @@ vector mc_vector_make_filled(size_t capacity, size_t length, long value);
  */
 vector mc_vector_clone(vector vec);
 
+/**
+ * @brief Creates a copy-on-write copy of a given vector, in constant time: both vectors share the same heap buffer,
+ *        through an (atomic) reference count, until one of them is modified. The first function modifying the
+ *        elements of a vector sharing its buffer (set, push, insert, remove, fill, resize, sort, ...) copies them
+ *        first; the last vector using the buffer frees it. Every vector created from a shared one by 
+ *        'mc_vector_clone' shares the buffer as well.
+ *        Vectors sharing a buffer can be given to different threads (each vector being used by a single thread),
+ *        for instance to hand read-only snapshots of a vector to reader threads. Inline elements and file mappings
+ *        are not shared: 'mc_vector_clone' is used for them instead.
+ * 
+ * @param[in] vec  The vector to be shared
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   Pointers given by 'mc_vector_data', 'mc_vector_begin', 'mc_vector_end' and 'mc_vector_span' (and the
+ *         inline accessors of MC_VECTOR_INLINE) do not copy anything: they must not be used to modify a vector
+ *         sharing its buffer, call 'mc_vector_unshare' first.
+ *         If given pointer is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno]  will be set to @c ENOBUFS  
+ */
+vector mc_vector_share(vector vec);
+
+/**
+ * @brief Makes sure the vector owns its elements: if its buffer is shared with other vectors (see 'mc_vector_share'),
+ *        the elements are copied into a buffer of the same capacity. Afterwards, they can be modified through
+ *        'mc_vector_data' until the next call that modifies the vector.
+ * 
+ * @param[inout] vec  The vector
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOMEM (and the vector still shares its buffer)
+ */
+short mc_vector_unshare(vector vec);
+
 /**
  * @brief Creates a vector representation of a given array
  * 
@@ -173,6 +493,38 @@ vector mc_vector_clone(vector vec);
  */
 vector mc_vector_from_array(long *src, size_t length);
 
+/**
+ * @brief Creates a vector which takes ownership of an existing buffer, without copying it.
+ * 
+ * @param[in] buffer    A buffer allocated with malloc, calloc or realloc
+ * @param[in] length    The number of elements already stored in the buffer
+ * @param[in] capacity  The number of elements that the buffer can hold
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   The buffer belongs to the vector once this function succeeded: it is released with free when the vector is
+ *         destroyed, or when it grows past 'capacity' (elements are then copied to a new buffer, allocated like any
+ *         other buffer of the vector). If this function fails, the caller still owns the buffer.
+ *         If given pointer is NULL, [errno] will be set to @c EFAULT
+ *         If given length or capacity is invalid (i.e. capacity == 0 or length > capacity), [errno] will be set to @c EINVAL
+ *         If allocation fails, [errno] will be set to @c ENOBUFS  
+ */
+vector mc_vector_adopt(long *buffer, size_t length, size_t capacity);
+
+/**
+ * @brief Creates a vector from the content of another vector, in constant time: the heap buffer (or the file mapping)
+ *        of 'src' is stolen, only elements stored on its stack buffer are copied. The new vector has the same stack
+ *        buffer size, allocator, growth policy and alignment as 'src'.
+ * 
+ * @param[inout] src  The vector to be moved, left empty (on its stack buffer) but still usable
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise.
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS, and 'src' is left untouched
+ */
+vector mc_vector_move(vector src);
+
 /**
  * @brief Destroys a given vector. Note that if given pointer is NULL, this function has no effect
  * 
@@ -210,6 +562,113 @@ int mc_vector_to_array(vector vec, long *buffer);
  */
 int mc_vector_extract(vector vec, long *buffer, size_t startIndex, size_t length);
 
+/**
+ * @brief Gives the elements of the vector away, in a buffer owned by the caller, and leaves the vector empty (on its
+ *        stack buffer, it can still be used).
+ * 
+ * @param[inout] vec     The vector to be emptied
+ * @param[out]   length  Where the number of elements of the returned buffer is stored
+ * 
+ * @return A buffer holding the elements of the vector, to be released with free, NULL if operation failed
+ * 
+ * @note   The heap buffer of the vector is returned as is when free can release it (a buffer given to
+ *         'mc_vector_adopt', or allocated by the standard allocator and not mapped from the system). Otherwise (stack
+ *         buffer, custom allocator, mapped buffer, 'mc_vector_mmap'), elements are copied to a new malloc'd buffer.
+ *         The returned buffer may be bigger than 'length' elements, and is never NULL for an empty vector.
+ *         If either vector or length is NULL, [errno] will be set to @c EFAULT
+ *         If allocation fails, [errno] will be set to @c ENOBUFS, and the vector is left untouched
+ */
+long *mc_vector_release(vector vec, size_t *length);
+
+/**
+ * @brief Gives a direct access to the internal buffer of the vector, without copying anything
+ * 
+ * @param[in] vec  A vector
+ * 
+ * @return A pointer to the first element of the vector, NULL if vector is NULL
+ * 
+ * @note   The pointer is borrowed from the vector: it stays valid until the next call that modifies the vector
+ *         (push, insert, remove, resize, ...) or until the vector is destroyed.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT  
+ */
+long *mc_vector_data(vector vec);
+
+/**
+ * @brief Gives a read-only view over the content of the vector, without copying anything
+ * 
+ * @param[in] vec  A vector
+ * 
+ * @return A span holding a pointer to the first element and the size of the vector, {NULL, 0} if vector is NULL
+ * 
+ * @note   The span is borrowed from the vector: it stays valid until the next call that modifies the vector
+ *         (push, insert, remove, resize, ...) or until the vector is destroyed.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT  
+ */
+vector_span mc_vector_span(vector vec);
+
+/**
+ * @brief Gives a pointer to the first element of the vector, to walk it with a plain pointer loop
+ *        (see MC_VECTOR_FOREACH)
+ * 
+ * @param[in] vec  A vector
+ * 
+ * @return A pointer to the first element of the vector, NULL if vector is NULL
+ * 
+ * @note   Like 'mc_vector_data', the pointer stays valid until the next call that modifies the vector.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT  
+ */
+long *mc_vector_begin(vector vec);
+
+/**
+ * @brief Gives a pointer past the last element of the vector (equal to 'mc_vector_begin' for an empty vector)
+ * 
+ * @param[in] vec  A vector
+ * 
+ * @return A pointer past the last element of the vector, NULL if vector is NULL
+ * 
+ * @note   Like 'mc_vector_data', the pointer stays valid until the next call that modifies the vector.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT  
+ */
+long *mc_vector_end(vector vec);
+
+/**
+ * @brief Walks every element of the vector with a pointer 'elem' (a long*, which can be used to modify the element).
+ *        The bounds are read once, the loop itself is a plain pointer loop. The vector must not be resized while
+ *        walking it, and nothing is done if it is NULL.
+ * 
+ *        MC_VECTOR_FOREACH(vec, it) { sum += *it; }
+ */
+#define MC_VECTOR_FOREACH(vec, elem) \
+    for (long *elem = mc_vector_begin(vec), *elem##_end = mc_vector_end(vec); elem != elem##_end; elem++)
+
+/**
+ * @brief Calls fn(element, ctx) on every element of the vector, in order
+ * 
+ * @param[in] vec  The vector to be read
+ * @param[in] fn   The function called on every element
+ * @param[in] ctx  A pointer passed to every call of fn, may be NULL
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   See 'mc_vector_for_each_fast' (with MC_VECTOR_INLINE) for a version which the compiler can inline.
+ *         If vector or fn is NULL, [errno] will be set to @c EFAULT  
+ */
+short mc_vector_for_each(vector vec, void (*fn)(long, void*), void *ctx);
+
+/**
+ * @brief Replaces every element of the vector by fn(element, ctx), in order (see 'mc_vector_par_transform' for a
+ *        multithreaded version)
+ * 
+ * @param[inout] vec  The vector to be transformed
+ * @param[in]    fn   The function applied to every element
+ * @param[in]    ctx  A pointer passed to every call of fn, may be NULL
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If vector or fn is NULL, [errno] will be set to @c EFAULT  
+ */
+short mc_vector_transform(vector vec, long (*fn)(long, void*), void *ctx);
+
 
 
 
@@ -301,6 +760,28 @@ short  mc_vector_empty(vector vec);
  */
 short mc_vector_is_stack(vector vec);
 
+/**
+ * @brief Whether the heap buffer is shared with other vectors (see 'mc_vector_share')
+ * 
+ * @param[in] vec  The vector to be checked
+ *  
+ * @return 1 if at least one other vector uses the same buffer, 0 otherwise
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned  
+ */
+short mc_vector_is_shared(vector vec);
+
+/**
+ * @brief The size of the stack buffer of the vector
+ * 
+ * @param[in] vec  A vector
+ *  
+ * @return The number of elements that can be stored on the vector's stack buffer
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned  
+ */
+size_t mc_vector_bufsize(vector vec);
+
 
 
 /**
@@ -329,6 +810,85 @@ short mc_vector_push(vector vec, long value);
  */
 long  mc_vector_pop(vector vec);
 
+/**
+ * @brief Inserts an array of elements at the end of the vector. Capacity is checked (and increased) only once.
+ * 
+ * @param[inout] vec     The vector to be modified 
+ * @param[in]    src     A pointer to an array of long integers
+ * @param[in]    length  The size of the array
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector or array is NULL, [errno] will be set to @c EFAULT
+ *         If given length is invalid (i.e. length == 0), [errno] will be set to @c EINVAL
+ *         If internal buffer is full, and reallocation failed, [errno] will be set to @c ENOMEM and
+ *           the vector will still be usable (except array has not been inserted)   
+ */
+short mc_vector_append(vector vec, const long *src, size_t length);
+
+/**
+ * @brief Inserts every element of a vector at the end of another one. Capacity is checked (and increased) only once.
+ * 
+ * @param[inout] dst  The vector to be modified 
+ * @param[in]    src  The vector to be copied (may be dst itself)
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector (dst or src) is NULL, [errno] will be set to @c EFAULT
+ *         If internal buffer is full, and reallocation failed, [errno] will be set to @c ENOMEM and
+ *           the vector will still be usable (except elements have not been inserted)   
+ */
+short mc_vector_append_vector(vector dst, vector src);
+
+/**
+ * @brief Inserts the same value several times at the end of the vector. Capacity is checked (and increased) only once.
+ * 
+ * @param[inout] vec     The vector to be modified 
+ * @param[in]    value   The value to be inserted
+ * @param[in]    length  The number of times the value should be inserted
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If given length is invalid (i.e. length == 0), [errno] will be set to @c EINVAL
+ *         If internal buffer is full, and reallocation failed, [errno] will be set to @c ENOMEM and
+ *           the vector will still be usable (except values have not been inserted)   
+ */
+short mc_vector_push_n(vector vec, long value, size_t length);
+
+/**
+ * @brief Inserts an element at the end of the vector. If the vector is full, the whole vector (attributes and elements)
+ *        is reallocated as a single block, instead of allocating a separate heap buffer. 
+ * 
+ * @param[inout] vec    A pointer to the vector to be modified. It is updated if the vector has been moved
+ * @param[in]    value  The value to be inserted
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   Since the vector may be moved, every other copy of the vector pointer is invalidated by this function.
+ *         If given pointer (vec or *vec) is NULL, [errno] will be set to @c EFAULT
+ *         If reallocation failed, [errno] will be set to @c ENOMEM and the vector will still be usable
+ *           (except value has not been inserted)   
+ */
+short mc_vector_push_block(vector *vec, long value);
+
+/**
+ * @brief Reallocates the vector as a single block holding at least 'capacity' elements. If the elements are currently
+ *        stored on a heap buffer, they are moved back into the block and the heap buffer is released.
+ * 
+ * @param[inout] vec       A pointer to the vector to be modified. It is updated if the vector has been moved
+ * @param[in]    capacity  The minimal capacity of the vector
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   Since the vector may be moved, every other copy of the vector pointer is invalidated by this function.
+ *         If given pointer (vec or *vec) is NULL, [errno] will be set to @c EFAULT
+ *         If given capacity is smaller than the vector's size, [errno] will be set to @c EINVAL
+ *         If reallocation failed, [errno] will be set to @c ENOMEM and the vector will still be usable
+ *           (except capacity won't be modified)   
+ */
+short mc_vector_reserve_block(vector *vec, size_t capacity);
+
 
 
 
@@ -360,7 +920,8 @@ short mc_vector_insert(vector vec, size_t index, long value);
  * @return 1 if operation succeded, 0 otherwise
  * 
  * @note   If given vector or array is NULL, [errno] will be set to @c EFAULT
- *         If given index is out of range, or length is invalid (i.e length == 0), [errno] will be set to @c EINVAL
+ *         If given index is out of range (i.e. index > size), or length is invalid (i.e length == 0), [errno] will
+ *           be set to @c EINVAL. Note that index == size appends the array at the end of the vector.
  *         If vector is full and reallocation failed, [errno] will be set to @c ENOMEM
  *           and vector will still be usable (except array won't be inserted)   
  */
@@ -390,29 +951,89 @@ short mc_vector_remove(vector vec, size_t index);
  * @param[in]    startIndex     The position of the first element to be removed
  * @param[in]    length         The number of element to remove
  * 
- * @return The number of element that has been removed from the vector 
+ * @return 1 if operation succeeded, 0 otherwise
  * 
  * @note   If given vector is NULL, [errno] will be set to @c EFAULT
  *         If given index is out of range or if length is invalid (i.e length == 0), [errno] will be set to @c EINVAL 
  */
 short mc_vector_erase(vector vec, size_t startIndex, size_t length);
 
+/**
+ * @brief Removes an element from the vector in constant time, by moving the last element in its place. This does not
+ *        preserve the order of the elements.
+ * 
+ * @param[inout] vec    The vector to be modified
+ * @param[in]    index  The position of the element to be removed
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If given index is out of range, [errno] will be set to @c EINVAL   
+ */
+short mc_vector_swap_remove(vector vec, size_t index);
+
+/**
+ * @brief Removes every element matching a predicate, in a single pass. The order of remaining elements is preserved.
+ * 
+ * @param[inout] vec   The vector to be modified
+ * @param[in]    pred  A function returning a non-zero value for the elements to be removed
+ * @param[in]    ctx   A pointer passed as last argument to every call of pred (may be NULL)
+ * 
+ * @return The number of elements that has been removed from the vector
+ * 
+ * @note   If given vector or function is NULL, [errno] will be set to @c EFAULT and 0 will be returned   
+ */
+size_t mc_vector_remove_if(vector vec, int (*pred)(long, void*), void *ctx);
+
+/**
+ * @brief Keeps only the elements matching a predicate, in a single pass. The order of remaining elements is preserved.
+ * 
+ * @param[inout] vec   The vector to be modified
+ * @param[in]    pred  A function returning a non-zero value for the elements to be kept
+ * @param[in]    ctx   A pointer passed as last argument to every call of pred (may be NULL)
+ * 
+ * @return The number of elements that has been removed from the vector
+ * 
+ * @note   If given vector or function is NULL, [errno] will be set to @c EFAULT and 0 will be returned   
+ */
+size_t mc_vector_retain(vector vec, int (*pred)(long, void*), void *ctx);
+
 
 
 
 
 /**
- * @brief Swaps the content of two vectors
+ * @brief Swaps the content of two vectors. Heap buffers (and file mappings) are exchanged without copying anything,
+ *        along with their capacity and alignment; only elements stored on a stack buffer are copied, so that the
+ *        swap is O(1) when both vectors are on the heap and O(bufsize) otherwise.
  * 
  * @param[inout] vec1  A vector
  * @param[inout] vec2  Another vector
  * 
  * @return 1 if operation succeeded, 0 otherwise
  * 
- * @note   If given vector is NULL, [errno] will be set to @c EFAULT  
+ * @note   Stack elements which do not fit in the stack buffer of the other vector are moved to a heap buffer first.
+ *         Vectors using different allocators keep their own buffers: their elements are exchanged one by one.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If a buffer cannot be grown, [errno] will be set to @c ENOMEM, and both vectors keep their content
  */
 short mc_vector_swap(vector vec1, vector vec2);
 
+/**
+ * @brief Replaces the content of a vector by the content of another one, which is left empty. The heap buffer (or the
+ *        file mapping) of 'src' is given to 'dst' without copying anything, the previous storage of 'dst' is freed.
+ * 
+ * @param[inout] dst  The vector receiving the elements
+ * @param[inout] src  The vector to be moved, left empty but still usable
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   Stack elements, and elements owned by another allocator than the one of 'dst', are copied instead.
+ *         If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If the buffer of 'dst' cannot be grown, [errno] will be set to @c ENOMEM, and both vectors are left untouched
+ */
+short mc_vector_move_assign(vector dst, vector src);
+
 /**
  * @brief Fills the vector with a given value
  * 
@@ -446,6 +1067,8 @@ short mc_vector_fill_range(vector vec, size_t startIndex, size_t length, long va
 /**
  * @brief Shrinks the internal buffer capacity to fit its size. Every unused memory "blocks" will be removed from the vector,
  *        which will cause its capacity to be equal to its size.
+ *        Large vectors (whose buffer is mapped from the system, see MC_VECTOR_MMAP_THRESHOLD) keep their buffer and
+ *        their capacity: the pages past the last element are given back to the system instead.
  * 
  * @param[inout] vec  The vector to be modified
  *  
@@ -475,7 +1098,9 @@ short mc_vector_shrink(vector vec);
 short mc_vector_resize(vector vec, size_t newSize);
 
 /**
- * @brief Clears the content of the vector
+ * @brief Clears the content of the vector. The heap buffer is freed, except for large vectors (whose buffer is mapped
+ *        from the system, see MC_VECTOR_MMAP_THRESHOLD): they keep their buffer and their capacity, and every page
+ *        of the buffer is given back to the system.
  * 
  * @param[inout] vec  The vector to be cleaned
  *  
@@ -485,6 +1110,395 @@ short mc_vector_resize(vector vec, size_t newSize);
  */
 short mc_vector_clear(vector vec);
 
+/**
+ * @brief Reserves room for new elements. After this call, 'length' elements can be inserted without any reallocation.
+ *        Unlike 'mc_vector_resize', this never removes elements and never reduces the capacity.
+ * 
+ * @param[inout] vec     The vector to be modified
+ * @param[in]    length  The number of elements that must fit in the buffer, in addition to the current ones
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If reallocation failed, [errno] will be set to @c ENOMEM
+ *           and vector will still be usable (except capacity won't be modified)   
+ */
+short mc_vector_reserve(vector vec, size_t length);
+
+/**
+ * @brief Sets how the vector grows when it gets full (see vector_growth for details). This has no effect on 
+ *        the current capacity.
+ * 
+ * @param[inout] vec     The vector to be modified
+ * @param[in]    policy  The new growth policy
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If given policy is not a vector_growth value, [errno] will be set to @c EINVAL
+ */
+short mc_vector_set_growth(vector vec, vector_growth policy);
+
+/**
+ * @brief Sets the alignment of the heap buffer of the vector. Heap buffers are aligned on MC_VECTOR_ALIGNMENT bytes
+ *        (a cache line) by default, or on the natural alignment of a long when the vector uses a custom allocator
+ *        (which then receives the alignment with every request). The alignment is kept when the vector grows, and 
+ *        by 'mc_vector_clone'. The current heap buffer is moved if it does not match the new alignment.
+ * 
+ * @param[inout] vec        The vector to be modified
+ * @param[in]    alignment  The new alignment, in bytes: a power of two, between the alignment of a long and
+ *                          MC_VECTOR_MAX_ALIGNMENT (a huge page)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If given alignment is not valid, [errno] will be set to @c EINVAL
+ *         If the heap buffer has to be moved and allocation fails, [errno] will be set to @c ENOMEM
+ *           and vector will still be usable (with its old alignment)
+ */
+short mc_vector_set_alignment(vector vec, size_t alignment);
+
+/**
+ * @brief Gets the alignment of the heap buffer of the vector (see 'mc_vector_set_alignment')
+ * 
+ * @param[in] vec  The vector
+ *  
+ * @return The alignment of the heap buffer, in bytes
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_vector_alignment(vector vec);
+
+/**
+ * @brief Gets the counters of the allocation cache of the calling thread (see MC_VECTOR_CACHE). Only allocations which
+ *        can be served by the cache are counted: headers of vectors created with the standard allocator and the
+ *        default stack buffer size, and heap buffers of at most MC_VECTOR_CACHE_MAX_BUFFER bytes.
+ * 
+ * @param[out] out  Where the counters are stored (all zero if the library was built without MC_VECTOR_CACHE)
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_cache_stats(vector_cache_stats *out);
+
+/**
+ * @brief Frees every header and heap buffer kept by the allocation cache of the calling thread, and resets its
+ *        counters. Cached memory is not freed when a thread exits: threads creating vectors should call this function
+ *        before exiting. Without MC_VECTOR_CACHE, this function has no effect.
+ */
+void mc_vector_cache_flush(void);
+
+/**
+ * @brief Reads the counters of the whole library (see MC_VECTOR_STATS), summed over every vector and every thread.
+ *        Peaks are the biggest values reached by a single vector since the last reset.
+ * 
+ * @return The counters, all zero if the library was built without MC_VECTOR_STATS
+ */
+vector_stats mc_vector_stats_snapshot(void);
+
+/**
+ * @brief Reads the counters of a single vector (see MC_VECTOR_STATS), since its creation. 'live_heap_bytes' is the size
+ *        of its current heap buffer.
+ * 
+ * @param[in]  vec  The vector
+ * @param[out] out  Where the counters are stored (all zero if the library was built without MC_VECTOR_STATS)
+ * 
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   Inline functions (MC_VECTOR_INLINE) only update counters when they fall back on the checked functions.
+ *         If either vector or out is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_stats(vector vec, vector_stats *out);
+
+/**
+ * @brief Resets the counters of the whole library, except 'live_heap_bytes'. Counters of vectors are left untouched.
+ */
+void mc_vector_stats_reset(void);
+
+
+
+
+/**
+ * @brief Computes the sum of every element of the vector. Overflow wraps around (as with unsigned integers), see
+ *        'mc_vector_sum_checked' to detect it.
+ * 
+ * @param[in]  vec  The vector to be read
+ * @param[out] out  A pointer to an integer where the sum will be stored (0 if the vector is empty)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec or out) is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_sum(vector vec, long *out);
+
+/**
+ * @brief Computes the sum of every element of the vector, checking for overflow. Only the final result has to fit in
+ *        a long: intermediate sums are computed without loss.
+ * 
+ * @param[in]  vec  The vector to be read
+ * @param[out] out  A pointer to an integer where the sum will be stored
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec or out) is NULL, [errno] will be set to @c EFAULT
+ *         If the sum does not fit in a long, [errno] will be set to @c ERANGE and out won't be modified  
+ */
+short mc_vector_sum_checked(vector vec, long *out);
+
+/**
+ * @brief Gets the smallest element of the vector
+ * 
+ * @param[in]  vec  The vector to be read
+ * @param[out] out  A pointer to an integer where the smallest element will be stored
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec or out) is NULL, [errno] will be set to @c EFAULT
+ *         If given vector is empty, [errno] will be set to @c EINVAL  
+ */
+short mc_vector_min(vector vec, long *out);
+
+/**
+ * @brief Gets the biggest element of the vector
+ * 
+ * @param[in]  vec  The vector to be read
+ * @param[out] out  A pointer to an integer where the biggest element will be stored
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec or out) is NULL, [errno] will be set to @c EFAULT
+ *         If given vector is empty, [errno] will be set to @c EINVAL  
+ */
+short mc_vector_max(vector vec, long *out);
+
+/**
+ * @brief Gets both the smallest and the biggest element of the vector, in a single pass
+ * 
+ * @param[in]  vec     The vector to be read
+ * @param[out] outMin  A pointer to an integer where the smallest element will be stored
+ * @param[out] outMax  A pointer to an integer where the biggest element will be stored
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec, outMin or outMax) is NULL, [errno] will be set to @c EFAULT
+ *         If given vector is empty, [errno] will be set to @c EINVAL  
+ */
+short mc_vector_minmax(vector vec, long *outMin, long *outMax);
+
+/**
+ * @brief Computes the dot product of two vectors (the sum of vec1[i] * vec2[i]). Overflow wraps around (as with 
+ *        unsigned integers), see 'mc_vector_dot_checked' to detect it.
+ * 
+ * @param[in]  vec1  A vector
+ * @param[in]  vec2  Another vector, of the same size
+ * @param[out] out   A pointer to an integer where the result will be stored (0 if the vectors are empty)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec1, vec2 or out) is NULL, [errno] will be set to @c EFAULT
+ *         If the vectors don't have the same size, [errno] will be set to @c EINVAL  
+ */
+short mc_vector_dot(vector vec1, vector vec2, long *out);
+
+/**
+ * @brief Computes the dot product of two vectors, checking for overflow. Products and sums are computed on a wider
+ *        integer type, and only the result has to fit in a long (on 64-bit platforms without a 128-bit integer type,
+ *        intermediate sums have to fit as well).
+ * 
+ * @param[in]  vec1  A vector
+ * @param[in]  vec2  Another vector, of the same size
+ * @param[out] out   A pointer to an integer where the result will be stored
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec1, vec2 or out) is NULL, [errno] will be set to @c EFAULT
+ *         If the vectors don't have the same size, [errno] will be set to @c EINVAL
+ *         If the result does not fit in a long, [errno] will be set to @c ERANGE and out won't be modified  
+ */
+short mc_vector_dot_checked(vector vec1, vector vec2, long *out);
+
+
+
+
+/**
+ * @brief Reads the elements at the given positions: out[i] = vec[indices[i]], using the hardware gather
+ *        instructions when available. Every index is checked before anything is written.
+ * 
+ * @param[in]  vec      The vector to be read
+ * @param[in]  indices  The positions to be read (may be repeated, in any order)
+ * @param[out] out      The vector where the elements will be stored (its content is replaced, it may be indices)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If out is vec, or if an index is invalid (i.e. index < 0 or index >= size), [errno] will be set to 
+ *         @c EINVAL and out won't be modified
+ *         If reallocation of out failed, [errno] will be set to @c ENOMEM  
+ */
+short mc_vector_gather(vector vec, vector indices, vector out);
+
+/**
+ * @brief Writes elements at the given positions: vec[indices[i]] = values[i], using the hardware scatter
+ *        instructions when available. If an index is repeated, the last value wins. Every index is checked before
+ *        anything is written.
+ * 
+ * @param[inout] vec      The vector to be modified
+ * @param[in]    indices  The positions to be written
+ * @param[in]    values   The elements to be written, as many as indices
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If vec is also an input, if indices and values don't have the same size, or if an index is invalid
+ *         (i.e. index < 0 or index >= size), [errno] will be set to @c EINVAL and vec won't be modified  
+ */
+short mc_vector_scatter(vector vec, vector indices, vector values);
+
+
+
+
+/**
+ * @brief Sorts the vector in ascending order. Vectors smaller than 'MC_VECTOR_RADIX_MIN' are sorted with an introsort,
+ *        bigger ones with a radix sort, which needs a scratch buffer as big as the vector: the unused part of the
+ *        vector's buffer is used if it is big enough, otherwise a temporary buffer is allocated. If that allocation
+ *        fails, the vector is sorted in place with the introsort.
+ * 
+ * @param[inout] vec  The vector to be sorted
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_sort(vector vec);
+
+/**
+ * @brief Sorts the vector using a custom ordering (introsort, not stable)
+ * 
+ * @param[inout] vec      The vector to be sorted
+ * @param[in]    compare  A function returning a negative integer if its first argument should be placed before its
+ *                        second one, a positive integer if it should be placed after, and 0 otherwise
+ * @param[in]    ctx      A pointer passed as last argument to every call of the compare function (may be NULL)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector or function is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_sort_by(vector vec, int (*compare)(long, long, void*), void *ctx);
+
+
+
+
+/**
+ * The following functions expect their input vectors to be sorted in ascending order (see 'mc_vector_sort'). 
+ * If they are not, results are unspecified (but memory safe).
+ * 
+ * Set operations ('mc_vector_merge', 'mc_vector_intersect' and 'mc_vector_difference') run in linear time and
+ * replace the content of their destination vector, which cannot be one of their inputs. Duplicates are handled
+ * as in a multiset (e.g. {1, 1, 2} intersected with {1, 1, 1} gives {1, 1}).
+ */
+
+/**
+ * @brief Finds the first element which is not smaller than a given value (branchless binary search)
+ * 
+ * @param[in] vec    A sorted vector
+ * @param[in] value  The value to be searched
+ *  
+ * @return The position of the first element greater than or equal to value, the size of the vector if there is
+ *         no such element
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_vector_lower_bound(vector vec, long value);
+
+/**
+ * @brief Searches a value in the vector
+ * 
+ * @param[in]  vec    A sorted vector
+ * @param[in]  value  The value to be searched
+ * @param[out] index  A pointer where the position of the value will be stored, if found (may be NULL)
+ *  
+ * @return 1 if value has been found, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_binary_search(vector vec, long value, size_t *index);
+
+/**
+ * @brief Inserts a batch of elements into a sorted vector, which stays sorted. Capacity is reserved once and the
+ *        batch is merged in a single backward pass, so that the whole operation runs in linear time (instead of
+ *        one tail move per element with 'mc_vector_insert'). Inserted elements are placed after equal elements.
+ *        The batch doesn't have to be sorted: if it is not, a sorted copy of it is made first.
+ * 
+ * @param[inout] vec     A sorted vector
+ * @param[in]    src     The elements to be inserted (they cannot be part of the vector)
+ * @param[in]    length  The number of elements to be inserted (may be 0)
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given pointer (vec or src) is NULL, [errno] will be set to @c EFAULT
+ *         If reallocation (or the copy of an unsorted batch) failed, [errno] will be set to @c ENOMEM and the
+ *         elements of the vector won't be modified  
+ */
+short mc_vector_insert_sorted_batch(vector vec, long *src, size_t length);
+
+/**
+ * @brief Removes consecutive duplicates from the vector, in a single pass. On a sorted vector, this leaves exactly
+ *        one copy of each value.
+ * 
+ * @param[inout] vec  The vector to be modified
+ *  
+ * @return The number of elements that has been removed
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_vector_unique(vector vec);
+
+/**
+ * @brief Merges two sorted vectors into a third one, which will also be sorted
+ * 
+ * @param[out] dst  The vector where the result will be stored
+ * @param[in]  a    A sorted vector
+ * @param[in]  b    Another sorted vector
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If dst is also an input, [errno] will be set to @c EINVAL
+ *         If reallocation of dst failed, [errno] will be set to @c ENOMEM (and dst will be empty)  
+ */
+short mc_vector_merge(vector dst, vector a, vector b);
+
+/**
+ * @brief Stores the elements that are both in a and b into a third vector, which will be sorted
+ * 
+ * @param[out] dst  The vector where the result will be stored
+ * @param[in]  a    A sorted vector
+ * @param[in]  b    Another sorted vector
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If dst is also an input, [errno] will be set to @c EINVAL
+ *         If reallocation of dst failed, [errno] will be set to @c ENOMEM (and dst will be empty)  
+ */
+short mc_vector_intersect(vector dst, vector a, vector b);
+
+/**
+ * @brief Stores the elements of a that are not in b into a third vector, which will be sorted
+ * 
+ * @param[out] dst  The vector where the result will be stored
+ * @param[in]  a    A sorted vector
+ * @param[in]  b    Another sorted vector
+ *  
+ * @return 1 if operation succeeded, 0 otherwise
+ * 
+ * @note   If given vector is NULL, [errno] will be set to @c EFAULT
+ *         If dst is also an input, [errno] will be set to @c EINVAL
+ *         If reallocation of dst failed, [errno] will be set to @c ENOMEM (and dst will be empty)  
+ */
+short mc_vector_difference(vector dst, vector a, vector b);
+
 
 
 #ifndef MC_VECTOR_NO_IO
@@ -497,7 +1511,22 @@ typedef enum {
 
 
 /**
- * @brief Prints a string representation of the vector into a given file, using the standard fprintf function.
+ * @brief Computes the exact length of the string representation of the vector, as printed by the following functions.
+ *        This can be used to size the buffer given to 'mc_vector_sprint' or 'mc_vector_wprint' (which also needs
+ *        room for the terminating null character).
+ * 
+ * @param[in] vec      The vector to be printed
+ * @param[in] option   The display option (see vector_display for details) 
+ * 
+ * @return The number of characters of the representation, not counting the terminating null character
+ * 
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT and 0 will be returned
+ */
+size_t mc_vector_print_length(vector vec, vector_display option);
+
+/**
+ * @brief Prints a string representation of the vector into a given file. Output is written by large chunks, using
+ *        the standard fwrite function.
  * 
  * @param[in] vec      The vector to be printed
  * @param[in] stream   A pointer to a file struct
@@ -511,42 +1540,209 @@ typedef enum {
 int mc_vector_fprint(vector vec, FILE *stream, vector_display option);
 
 /**
- * @brief Prints a string representation of the vector into a given string, using the standard sprintf function
+ * @brief Prints a string representation of the vector into a given string. The string is always null-terminated,
+ *        and the representation is truncated if it does not fit (see 'mc_vector_print_length').
  * 
  * @param[in] vec           The vector to be printed
  * @param[in] buffer        A character string
  * @param[in] bufferLen     The size of the string
  * @param[in] option        The display option (see vector_display for details)
  * 
- * @return The number of characters that has been printed into the string
+ * @return The number of characters that has been printed into the string (not counting the null character)
  * 
  * @note   If vector is NULL, [errno] will be set to @c EFAULT  
- *         If buflen is invalid (i.e buflen < 0), [errno] will be set to @c EINVAL
- *         If printing fails, see the documentation of your C Library implementation for details
- * 
- *         Note that if you compile this code on Windows, we will use the 'sprint_f' function, but on Linux
- *         we use the classic 'sprintf' function. Although we check for memory overflow before writing any data,
- *         this makes this function less safe on Linux. Be careful when using it.  
+ *         If buflen is invalid (i.e buflen <= 0), [errno] will be set to @c EINVAL
  */
 int mc_vector_sprint(vector vec, char *buffer, int bufferLen, vector_display option);
 
 /**
- * @brief Prints a string representation of the vector into a given multibyte string, using the standard swprintf function
+ * @brief Prints a string representation of the vector into a given multibyte string. The string is always 
+ *        null-terminated, and the representation is truncated if it does not fit (see 'mc_vector_print_length').
  * 
  * @param[in] vec           The vector to be printed
  * @param[in] buffer        A multibyte character string
  * @param[in] bufferLen     The size of the string
  * @param[in] option        The display option (see vector_display for details)
  * 
- * @return The number of characters that has been printed into the string
+ * @return The number of characters that has been printed into the string (not counting the null character)
  * 
  * @note   If vector is NULL, [errno] will be set to @c EFAULT
- *         If buflen is invalid (i.e buflen < 0), [errno] will be set to @c EINVAL
- *         If printing fails, see the documentation of your C Library implementation for details   
+ *         If buflen is invalid (i.e buflen <= 0), [errno] will be set to @c EINVAL
  */
 int mc_vector_wprint(vector vec, wchar_t *buffer, int bufferLen, vector_display option);
 
+/**
+ * @brief Creates a vector from its string representation, in one of the display formats:
+ *              - VDisplay_SingleLine: elements separated by commas, between brackets ("{1, -2, 3}"),
+ *              - VDisplay_OnePerLine: one element per line (blank lines are ignored),
+ *              - VDisplay_Raw:        elements separated by whitespaces or by commas.
+ *        Whitespaces are allowed around every element, and elements may have a sign. Digits are converted 8 at a time,
+ *        without strtol.
+ * 
+ * @param[in] buffer        A character string, which does not need to be null-terminated
+ * @param[in] length        The number of characters to be parsed
+ * @param[in] option        The format of the string (see vector_display for details)
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ * 
+ * @note   If buffer is NULL, [errno] will be set to @c EFAULT
+ *         If the string does not match the format, [errno] will be set to @c EINVAL
+ *         If an element does not fit in a long, [errno] will be set to @c ERANGE
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_vector_parse(const char *buffer, size_t length, vector_display option);
+
+/**
+ * @brief Creates a vector from a string representation read from a given file (see 'mc_vector_parse' for the
+ *        accepted formats). The file is read by chunks, until its end.
+ * 
+ * @param[in] stream        A pointer to a file struct
+ * @param[in] option        The format of the file (see vector_display for details)
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ * 
+ * @note   If stream is NULL, [errno] will be set to @c EFAULT
+ *         If the content does not match the format, [errno] will be set to @c EINVAL
+ *         If an element does not fit in a long, [errno] will be set to @c ERANGE
+ *         If reading fails, [errno] will be set to @c EIO
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_vector_fparse(FILE *stream, vector_display option);
+
+
+
+// The version of the binary format written by 'mc_vector_write_binary'
+#define MC_VECTOR_BINARY_VERSION 1
+
+/**
+ * @brief Writes the vector into a given file, in a binary format: a 16 bytes header (magic number, format version,
+ *        element width, byte order and number of elements) followed by the raw elements. The file must be opened
+ *        in binary mode.
+ * 
+ * @param[in] vec      The vector to be written
+ * @param[in] stream   A pointer to a file struct
+ * 
+ * @return 1 if the operation succeeded, 0 otherwise
+ * 
+ * @note   If vector or stream is NULL, [errno] will be set to @c EFAULT
+ *         If writing fails, [errno] will be set to @c EIO
+ */
+short mc_vector_write_binary(vector vec, FILE *stream);
+
+/**
+ * @brief Reads a vector written by 'mc_vector_write_binary' from a given file. Files written on a platform with
+ *        another element width or byte order are converted while reading.
+ * 
+ * @param[in] stream   A pointer to a file struct, opened in binary mode
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ * 
+ * @note   If stream is NULL, [errno] will be set to @c EFAULT
+ *         If the header is invalid, [errno] will be set to @c EINVAL
+ *         If the file is truncated or reading fails, [errno] will be set to @c EIO
+ *         If an element does not fit in a long, [errno] will be set to @c ERANGE
+ *         If allocation fails, [errno] will be set to @c ENOBUFS
+ */
+vector mc_vector_read_binary(FILE *stream);
+
+/**
+ * @brief Loads a vector written by 'mc_vector_write_binary' by mapping the file into memory: the data of the vector
+ *        points straight into the mapping, so nothing is parsed nor copied, and pages are only read from the disk
+ *        when they are accessed.
+ *        The file is opened read-only and is never modified: the mapping is private, so writing an element only
+ *        changes a private copy of its page. The first operation which needs a bigger or smaller buffer moves the
+ *        content to the heap and releases the mapping. The vector must be destroyed with 'mc_vector_free'.
+ * 
+ * @param[in] path     The path of the file
+ * 
+ * @return A pointer to a new vector if operation succeeded, NULL otherwise
+ * 
+ * @note   If path is NULL, [errno] will be set to @c EFAULT
+ *         If the header is invalid, or if the file was written with another element width or byte order (use
+ *         'mc_vector_read_binary' to convert it), [errno] will be set to @c EINVAL
+ *         If the platform has no mmap, [errno] will be set to @c ENOSYS
+ *         If opening or mapping the file fails, [errno] is set by the system
+ */
+vector mc_vector_mmap(const char *path);
+
 
 #endif /* MC_VECTOR_NO_IO */
 
+
+
+#ifdef MC_VECTOR_INLINE
+
+/**
+ * @brief Gets an element from the vector. Unlike 'mc_vector_get', nothing is checked.
+ * 
+ * @param[in] vec       The vector to be read (must not be NULL)
+ * @param[in] index     The position of the element on the vector (must be smaller than the vector's size)
+ * 
+ * @return The element located at index
+ */
+static inline long mc_vector_get_fast(vector vec, size_t index) {
+    return vec->data[index];
+}
+
+/**
+ * @brief Sets the value of an element on the vector. Unlike 'mc_vector_set', nothing is checked (nor copied, see
+ *        'mc_vector_unshare').
+ * 
+ * @param[inout] vec     The vector to be modified (must not be NULL)
+ * @param[in]    index   The position of the element (must be smaller than the vector's size)
+ * @param[in]    value   The new value of the element
+ */
+static inline void mc_vector_set_fast(vector vec, size_t index, long value) {
+    vec->data[index] = value;
+}
+
+/**
+ * @brief Inserts an element at the end of the vector. If the internal buffer has room left, the element is
+ *        stored directly; otherwise this falls back on 'mc_vector_push' to grow the buffer. The vector must not share
+ *        its buffer (see 'mc_vector_unshare').
+ * 
+ * @param[inout] vec    The vector to be modified (must not be NULL)
+ * @param[in]    value  The value to be inserted
+ * 
+ * @return 1 if operation succeeded, 0 otherwise (see 'mc_vector_push')
+ */
+static inline short mc_vector_push_fast(vector vec, long value) {
+    if (vec->count < vec->capacity) {
+        vec->data[vec->count++] = value;
+        return 1;
+    }
+
+    return mc_vector_push(vec, value);
+}
+
+/**
+ * @brief Removes the last element of the vector. Unlike 'mc_vector_pop', nothing is checked.
+ * 
+ * @param[inout] vec  The vector to be modified (must not be NULL nor empty)
+ * 
+ * @return The element that has just been removed from the vector
+ */
+static inline long mc_vector_pop_fast(vector vec) {
+    return vec->data[--vec->count];
+}
+
+/**
+ * @brief Calls fn(element, ctx) on every element of the vector, in order. Unlike 'mc_vector_for_each', nothing is
+ *        checked, and since this function is inline, a visitor known at compile time can be inlined in the loop.
+ * 
+ * @param[in] vec  The vector to be read (must not be NULL)
+ * @param[in] fn   The function called on every element (must not be NULL)
+ * @param[in] ctx  A pointer passed to every call of fn, may be NULL
+ */
+static inline void mc_vector_for_each_fast(vector vec, void (*fn)(long, void*), void *ctx) {
+    for (const long *it = vec->data, *end = vec->data + vec->count; it != end; it++)
+        fn(*it, ctx);
+}
+
+#endif /* MC_VECTOR_INLINE */
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* Header Guard */
\ No newline at end of file
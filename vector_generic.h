@@ -0,0 +1,607 @@
+/**
+ * @file   vector_generic.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Type-parameterized version of the vector library. 'vector.h' is hard-wired to 'long'; the macros of this file
+ *         stamp out a copy of the same API for any element type, with the element size and the small buffer size known
+ *         at compile time (so that copies, moves and fills can be specialized by the compiler).
+ *
+ *         MC_VECTOR_DECLARE(name, T, bufsize) declares the 'name' type (a pointer to 'struct name##_s', like 'vector')
+ *         and the prototypes of every function, prefixed by 'name' (name##_make, name##_push, ...). The struct layout
+ *         is part of the declaration, so that 'MC_VECTOR_STATIC' can be used from headers.
+ *         It is meant to be used in a header.
+ *
+ *         MC_VECTOR_DEFINE(name, T, bufsize) defines those functions. It must be used [[ONCE]], in a single translation
+ *         unit, after MC_VECTOR_DECLARE has been used with the same arguments.
+ *
+ *         MC_VECTOR_STATIC(name, T, bufsize) does both at once, but every function is 'static inline'. This is the
+ *         header-only way of using a generated vector.
+ *
+ *         Example:
+ *
+ *              MC_VECTOR_DECLARE(dvector, double, 16)      // in dvector.h
+ *              MC_VECTOR_DEFINE(dvector, double, 16)       // in dvector.c
+ *
+ *              dvector v = dvector_make(32);
+ *              dvector_push(v, 3.14);
+ *              dvector_free(v);
+ *
+ *         Functions behave like their 'mc_vector_*' counterparts (same return values, same [errno] codes), with the
+ *         following differences:
+ *              - index arguments are checked against the size of the vector, not its capacity,
+ *              - 'name##_insert' and 'name##_inserts' accept index == size (which appends),
+ *              - 'mc_vector_get_unchecked' is replaced by 'name##_at', which returns a pointer (NULL if out of range),
+ *              - 'mc_vector_span' is named 'name##_span_of', since 'name##_span' is the span type,
+ *              - 'name##_pop' returns a zero-filled element if the vector is NULL or empty,
+ *              - there is no print function, since we don't know how to print a T.
+ *
+ *         T must be trivially copyable (elements are moved around with memcpy / memmove), and bufsize must be at
+ *         least 1. The generated code is valid C99 and C++, and declarations get C linkage when included from C++,
+ *         so that a vector defined in a C translation unit can be used from C++ ones (and the other way around).
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_VECTOR_GENERIC_H
+#define MC_VECTOR_GENERIC_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#ifdef __cplusplus
+#   define MC_VECTOR_BEGIN_DECLS    extern "C" {
+#   define MC_VECTOR_END_DECLS      }
+#else
+#   define MC_VECTOR_BEGIN_DECLS
+#   define MC_VECTOR_END_DECLS
+#endif
+
+
+#define MC_VECTOR_DECLARE(name, T, bufsize)         MC_VECTOR_DECLARE_(name, T, bufsize, extern)
+#define MC_VECTOR_DEFINE(name, T, bufsize)          MC_VECTOR_DEFINE_(name, T, bufsize, )
+
+#define MC_VECTOR_STATIC(name, T, bufsize)                                                                          \
+    MC_VECTOR_DECLARE_(name, T, bufsize, static inline)                                                             \
+    MC_VECTOR_DEFINE_(name, T, bufsize, static inline)
+
+
+
+#define MC_VECTOR_DECLARE_(name, T, bufsize, scope)                                                                 \
+MC_VECTOR_BEGIN_DECLS                                                                                               \
+                                                                                                                    \
+typedef struct name##_s * name;                                                                                     \
+                                                                                                                    \
+typedef struct {                                                                                                    \
+    const T *data;                                                                                                  \
+    size_t   length;                                                                                                \
+} name##_span;                                                                                                      \
+                                                                                                                    \
+struct name##_s {                                                                                                   \
+    size_t count;                                                                                                   \
+    size_t capacity;                                                                                                \
+                                                                                                                    \
+    T  stack_buf[bufsize];                                                                                          \
+    T *heap_buf;                                                                                                    \
+                                                                                                                    \
+    T *data;                                                                                                        \
+};                                                                                                                  \
+                                                                                                                    \
+scope name   name##_make(size_t capacity);                                                                          \
+scope name   name##_make_filled(size_t capacity, size_t length, T value);                                           \
+scope name   name##_clone(name vec);                                                                                \
+scope name   name##_from_array(const T *src, size_t length);                                                        \
+scope void   name##_free(name vec);                                                                                 \
+                                                                                                                    \
+scope int    name##_to_array(name vec, T *buffer);                                                                  \
+scope int    name##_extract(name vec, T *buffer, size_t startIndex, size_t length);                                 \
+scope T     *name##_data(name vec);                                                                                 \
+scope name##_span name##_span_of(name vec);                                                                         \
+                                                                                                                    \
+scope short  name##_get(name vec, size_t index, T *out);                                                            \
+scope T     *name##_at(name vec, size_t index);                                                                     \
+scope short  name##_set(name vec, size_t index, T value);                                                           \
+                                                                                                                    \
+scope size_t name##_size(name vec);                                                                                 \
+scope size_t name##_capacity(name vec);                                                                             \
+scope short  name##_empty(name vec);                                                                                \
+scope short  name##_is_stack(name vec);                                                                             \
+                                                                                                                    \
+scope short  name##_push(name vec, T value);                                                                        \
+scope T      name##_pop(name vec);                                                                                  \
+                                                                                                                    \
+scope short  name##_insert(name vec, size_t index, T value);                                                        \
+scope short  name##_inserts(name vec, size_t index, const T *src, size_t length);                                   \
+                                                                                                                    \
+scope short  name##_remove(name vec, size_t index);                                                                 \
+scope short  name##_erase(name vec, size_t startIndex, size_t length);                                              \
+                                                                                                                    \
+scope short  name##_swap(name vec1, name vec2);                                                                     \
+scope short  name##_fill(name vec, T value);                                                                        \
+scope short  name##_fill_range(name vec, size_t startIndex, size_t length, T value);                                \
+                                                                                                                    \
+scope short  name##_shrink(name vec);                                                                               \
+scope short  name##_resize(name vec, size_t newSize);                                                               \
+scope short  name##_clear(name vec);                                                                                \
+scope short  name##_reserve(name vec, size_t length);                                                               \
+                                                                                                                    \
+MC_VECTOR_END_DECLS
+
+
+
+#define MC_VECTOR_DEFINE_(name, T, bufsize, scope)                                                                  \
+                                                                                                                    \
+static inline short name##_ensure_capacity_(name vec, size_t len) {                                                 \
+    if (len <= vec->capacity - vec->count)                                                                          \
+        return 1;                                                                                                   \
+                                                                                                                    \
+    if (len > SIZE_MAX / sizeof (T) - vec->count)                                                                   \
+        return 0;                                                                                                   \
+                                                                                                                    \
+    const size_t needed = vec->count + len;                                                                         \
+    const size_t cap = (vec->capacity < SIZE_MAX / sizeof (T) / 2 && vec->capacity * 2 > needed)                    \
+                     ? vec->capacity * 2 : needed;                                                                  \
+    T *temp = (T*)(realloc(vec->heap_buf, cap * sizeof (T)));                                                       \
+                                                                                                                    \
+    if (!temp)                                                                                                      \
+        return 0;                                                                                                   \
+                                                                                                                    \
+    if (vec->heap_buf == NULL)                                                                                      \
+        memcpy(temp, vec->stack_buf, vec->count * sizeof (T));                                                      \
+                                                                                                                    \
+    vec->heap_buf = temp;                                                                                           \
+    vec->data = temp;                                                                                               \
+    vec->capacity = cap;                                                                                            \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_fill_(T *dst, size_t length, T value) {                                                   \
+    if (sizeof (T) == 1) {                                                                                          \
+        memset(dst, *(const unsigned char*)(&value), length);                                                       \
+        return;                                                                                                     \
+    }                                                                                                               \
+                                                                                                                    \
+    for (size_t i = 0; i < length; i++)                                                                             \
+        dst[i] = value;                                                                                             \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope name name##_make(size_t capacity) {                                                                           \
+    if (capacity == 0) {                                                                                            \
+        errno = EINVAL;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    name res = (name)(malloc(sizeof (struct name##_s)));                                                            \
+                                                                                                                    \
+    if (!res) {                                                                                                     \
+        errno = ENOBUFS;                                                                                            \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    if (capacity > (bufsize)) {                                                                                     \
+        res->heap_buf = (capacity <= SIZE_MAX / sizeof (T)) ? (T*)(malloc(capacity * sizeof (T))) : NULL;           \
+                                                                                                                    \
+        if (!res->heap_buf) {                                                                                       \
+            free(res);                                                                                              \
+            errno = ENOBUFS;                                                                                        \
+            return NULL;                                                                                            \
+        }                                                                                                           \
+                                                                                                                    \
+        res->data = res->heap_buf;                                                                                  \
+        res->capacity = capacity;                                                                                   \
+    }                                                                                                               \
+    else {                                                                                                          \
+        res->data = res->stack_buf;                                                                                 \
+        res->heap_buf = NULL;                                                                                       \
+        res->capacity = (bufsize);                                                                                  \
+    }                                                                                                               \
+                                                                                                                    \
+    res->count = 0;                                                                                                 \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+scope name name##_make_filled(size_t capacity, size_t length, T value) {                                            \
+    if (capacity == 0 || length == 0 || capacity < length) {                                                        \
+        errno = EINVAL;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    name res = name##_make(capacity);                                                                               \
+                                                                                                                    \
+    if (!res)                                                                                                       \
+        return NULL;                                                                                                \
+                                                                                                                    \
+    name##_fill_(res->data, length, value);                                                                         \
+    res->count = length;                                                                                            \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+scope name name##_clone(name vec) {                                                                                 \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    name res = name##_make(vec->capacity);                                                                          \
+                                                                                                                    \
+    if (!res)                                                                                                       \
+        return NULL;                                                                                                \
+                                                                                                                    \
+    memcpy(res->data, vec->data, vec->count * sizeof (T));                                                          \
+    res->count = vec->count;                                                                                        \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+scope name name##_from_array(const T *src, size_t length) {                                                         \
+    if (!src) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    if (length == 0) {                                                                                              \
+        errno = EINVAL;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    if (length > SIZE_MAX / sizeof (T) / 2) {                                                                       \
+        errno = ENOBUFS;                                                                                            \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    name res = name##_make(length * 2);                                                                             \
+                                                                                                                    \
+    if (!res)                                                                                                       \
+        return NULL;                                                                                                \
+                                                                                                                    \
+    memcpy(res->data, src, length * sizeof (T));                                                                    \
+    res->count = length;                                                                                            \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+scope void name##_free(name vec) {                                                                                  \
+    if (!vec)                                                                                                       \
+        return;                                                                                                     \
+                                                                                                                    \
+    free(vec->heap_buf);                                                                                            \
+    free(vec);                                                                                                      \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope int name##_to_array(name vec, T *buffer) {                                                                    \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return name##_extract(vec, buffer, 0, vec->count);                                                              \
+}                                                                                                                   \
+                                                                                                                    \
+scope int name##_extract(name vec, T *buffer, size_t index, size_t length) {                                        \
+    if (!vec || !buffer) {                                                                                          \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index >= vec->count || length == 0 || index + length > vec->count) {                                        \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    memcpy(buffer, vec->data + index, length * sizeof (T));                                                         \
+    return (int)length;                                                                                             \
+}                                                                                                                   \
+                                                                                                                    \
+scope T *name##_data(name vec) {                                                                                    \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return NULL;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    return vec->data;                                                                                               \
+}                                                                                                                   \
+                                                                                                                    \
+scope name##_span name##_span_of(name vec) {                                                                        \
+    name##_span res = { NULL, 0 };                                                                                  \
+                                                                                                                    \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return res;                                                                                                 \
+    }                                                                                                               \
+                                                                                                                    \
+    res.data = vec->data;                                                                                           \
+    res.length = vec->count;                                                                                        \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_get(name vec, size_t index, T *out) {                                                            \
+    if (!vec || !out) {                                                                                             \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index >= vec->count) {                                                                                      \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    *out = vec->data[index];                                                                                        \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope T *name##_at(name vec, size_t index) {                                                                        \
+    if (!vec || index >= vec->count)                                                                                \
+        return NULL;                                                                                                \
+                                                                                                                    \
+    return vec->data + index;                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_set(name vec, size_t index, T value) {                                                           \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index >= vec->count) {                                                                                      \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    vec->data[index] = value;                                                                                       \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope size_t name##_size(name vec) {                                                                                \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return vec->count;                                                                                              \
+}                                                                                                                   \
+                                                                                                                    \
+scope size_t name##_capacity(name vec) {                                                                            \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return vec->capacity;                                                                                           \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_empty(name vec) {                                                                                \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 1;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return vec->count == 0;                                                                                         \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_is_stack(name vec) {                                                                             \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return vec->data != vec->heap_buf;                                                                              \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_push(name vec, T value) {                                                                        \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (!name##_ensure_capacity_(vec, 1)) {                                                                         \
+        errno = ENOMEM;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    vec->data[vec->count++] = value;                                                                                \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope T name##_pop(name vec) {                                                                                      \
+    T res;                                                                                                          \
+                                                                                                                    \
+    if (!vec || vec->count == 0) {                                                                                  \
+        errno = vec ? ENOMEM : EFAULT;                                                                              \
+        memset(&res, 0, sizeof res);                                                                                \
+        return res;                                                                                                 \
+    }                                                                                                               \
+                                                                                                                    \
+    res = vec->data[--vec->count];                                                                                  \
+    return res;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_insert(name vec, size_t index, T value) {                                                        \
+    return name##_inserts(vec, index, &value, 1);                                                                   \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_inserts(name vec, size_t index, const T *src, size_t length) {                                   \
+    if (!vec || !src) {                                                                                             \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index > vec->count || length == 0) {                                                                        \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (!name##_ensure_capacity_(vec, length)) {                                                                    \
+        errno = ENOMEM;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    memmove(vec->data + index + length, vec->data + index, (vec->count - index) * sizeof (T));                      \
+    memcpy(vec->data + index, src, length * sizeof (T));                                                            \
+                                                                                                                    \
+    vec->count += length;                                                                                           \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_remove(name vec, size_t index) {                                                                 \
+    return name##_erase(vec, index, 1);                                                                             \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_erase(name vec, size_t index, size_t length) {                                                   \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index >= vec->count || length == 0 || length > vec->count - index) {                                        \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    memmove(vec->data + index, vec->data + index + length, (vec->count - index - length) * sizeof (T));             \
+                                                                                                                    \
+    vec->count -= length;                                                                                           \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_swap(name vec1, name vec2) {                                                                     \
+    if (!vec1 || !vec2) {                                                                                           \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    const short stack1 = vec1->data != vec1->heap_buf;                                                              \
+    const short stack2 = vec2->data != vec2->heap_buf;                                                              \
+    struct name##_s temp = *vec1;                                                                                   \
+                                                                                                                    \
+    *vec1 = *vec2;                                                                                                  \
+    *vec2 = temp;                                                                                                   \
+                                                                                                                    \
+    /* inline buffers have been copied, so pointers to them have to follow */                                       \
+    if (stack2)                                                                                                     \
+        vec1->data = vec1->stack_buf;                                                                               \
+    if (stack1)                                                                                                     \
+        vec2->data = vec2->stack_buf;                                                                               \
+                                                                                                                    \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_fill(name vec, T value) {                                                                        \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return name##_fill_range(vec, 0, vec->count, value);                                                            \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_fill_range(name vec, size_t index, size_t length, T value) {                                     \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (index >= vec->count || length == 0 || length > vec->count - index) {                                        \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    name##_fill_(vec->data + index, length, value);                                                                 \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+                                                                                                                    \
+scope short name##_shrink(name vec) {                                                                               \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return name##_resize(vec, vec->count ? vec->count : 1);                                                         \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_resize(name vec, size_t newSize) {                                                               \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (newSize == 0) {                                                                                             \
+        errno = EINVAL;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (newSize < vec->count)                                                                                       \
+        vec->count = newSize;                                                                                       \
+                                                                                                                    \
+    if (newSize <= (bufsize)) {                                                                                     \
+        /* new size is small enough to fit in the stack buffer */                                                   \
+        if (vec->heap_buf) {                                                                                        \
+            memcpy(vec->stack_buf, vec->heap_buf, vec->count * sizeof (T));                                         \
+            free(vec->heap_buf);                                                                                    \
+            vec->heap_buf = NULL;                                                                                   \
+        }                                                                                                           \
+                                                                                                                    \
+        vec->data = vec->stack_buf;                                                                                 \
+        vec->capacity = (bufsize);                                                                                  \
+        return 1;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    T *temp = (newSize <= SIZE_MAX / sizeof (T)) ? (T*)(realloc(vec->heap_buf, newSize * sizeof (T))) : NULL;       \
+                                                                                                                    \
+    if (!temp) {                                                                                                    \
+        errno = ENOMEM;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (!vec->heap_buf)                                                                                             \
+        memcpy(temp, vec->stack_buf, vec->count * sizeof (T));                                                      \
+                                                                                                                    \
+    vec->heap_buf = temp;                                                                                           \
+    vec->data = temp;                                                                                               \
+    vec->capacity = newSize;                                                                                        \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_reserve(name vec, size_t length) {                                                               \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    if (!name##_ensure_capacity_(vec, length)) {                                                                    \
+        errno = ENOMEM;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    return 1;                                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+scope short name##_clear(name vec) {                                                                                \
+    if (!vec) {                                                                                                     \
+        errno = EFAULT;                                                                                             \
+        return 0;                                                                                                   \
+    }                                                                                                               \
+                                                                                                                    \
+    free(vec->heap_buf);                                                                                            \
+    vec->heap_buf = NULL;                                                                                           \
+    vec->data = vec->stack_buf;                                                                                     \
+    vec->capacity = (bufsize);                                                                                      \
+    vec->count = 0;                                                                                                 \
+    return 1;                                                                                                       \
+}
+
+#endif /* Header Guard */
@@ -0,0 +1,726 @@
+/**
+ * @file   vector_parallel.c
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Implementation of the parallel operations (see vector_parallel.h). Requires POSIX threads.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MC_VECTOR_INLINE
+#include "vector_parallel.h"
+
+
+// Chunk boundaries are aligned on this many bytes
+#define VEC_PAR_LINE 64
+
+// The maximal number of threads of the pool
+#define VEC_PAR_MAX_THREADS 256
+
+// The number of buckets of a radix sort pass (8 bits per pass)
+#define VEC_PAR_RADIX 256
+
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+
+#if MC_VECTOR_PAR_CHUNK < VEC_PAR_LINE
+#   error "MC_VECTOR_PAR_CHUNK is too small"
+#endif
+
+
+
+// Thread pool. An operation is a number of chunks and a task, called once per chunk. Every thread (the caller being
+// thread 0) owns a range of chunks: it takes chunks from the front of its own range, and steals the back half of
+// another range once its own is empty
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t begin;                           // The next chunk to be processed
+    size_t end;                             // The end of the range
+    char   pad[VEC_PAR_LINE];               // Keeps ranges of different threads on different cache lines
+} vec_par_range;
+
+typedef struct {
+    size_t threads;                         // The number of threads of an operation, the caller included
+    pthread_t *workers;                     // The threads of the pool (threads - 1)
+    vec_par_range *ranges;                  // One range per thread
+
+    pthread_mutex_t lock;                   // Protects every following field
+    pthread_cond_t  wake;                   // Signaled when an operation starts, or when the pool stops
+    pthread_cond_t  done;                   // Signaled when the last worker finishes an operation
+    unsigned long generation;               // Incremented for every operation
+    size_t active;                          // The number of workers still busy with the current operation
+    short  stop;                            // Whether threads have to exit
+
+    void (*task)(void *ctx, size_t chunk);  // The task of the current operation
+    void  *ctx;                             // Passed to every call of task
+} vec_par_pool;
+
+typedef struct {
+    vec_par_pool *pool;
+    size_t id;                              // The index of the range of the worker
+} vec_par_worker;
+
+// Serializes operations, and protects the pool pointer
+static pthread_mutex_t vec_par_lock = PTHREAD_MUTEX_INITIALIZER;
+static vec_par_pool *vec_par = NULL;
+static vec_par_worker vec_par_workers[VEC_PAR_MAX_THREADS];
+static size_t vec_par_cutoff = MC_VECTOR_PAR_CUTOFF;
+
+
+// Takes a chunk from the range of a thread, or steals from another one. Returns 0 if there is nothing left to do
+static short vec_par_next(vec_par_pool *pool, size_t id, size_t *chunk) {
+    vec_par_range *own = pool->ranges + id;
+
+    pthread_mutex_lock(&own->lock);
+
+    if (own->begin < own->end) {
+        *chunk = own->begin++;
+        pthread_mutex_unlock(&own->lock);
+        return 1;
+    }
+
+    pthread_mutex_unlock(&own->lock);
+
+    for (size_t i = 1; i < pool->threads; i++) {
+        vec_par_range *victim = pool->ranges + (id + i) % pool->threads;
+        size_t begin = 0, end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+
+        if (victim->begin < victim->end) {
+            // steal the back half (at least one chunk)
+            end = victim->end;
+            begin = victim->end - (victim->end - victim->begin + 1) / 2;
+            victim->end = begin;
+        }
+
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin + 1;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+
+            *chunk = begin;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void vec_par_work(vec_par_pool *pool, size_t id) {
+    size_t chunk;
+
+    while (vec_par_next(pool, id, &chunk))
+        pool->task(pool->ctx, chunk);
+}
+
+static void *vec_par_main(void *arg) {
+    vec_par_worker *self = (vec_par_worker*)(arg);
+    vec_par_pool *pool = self->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+
+        if (pool->stop)
+            break;
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        vec_par_work(pool, self->id);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->done);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Stops and destroys the pool, vec_par_lock must be held
+static void vec_par_destroy(void) {
+    vec_par_pool *pool = vec_par;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i + 1 < pool->threads; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    for (size_t i = 0; i < pool->threads; i++)
+        pthread_mutex_destroy(&pool->ranges[i].lock);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+
+    free(pool->workers);
+    free(pool->ranges);
+    free(pool);
+
+    vec_par = NULL;
+}
+
+// Creates the pool, vec_par_lock must be held. Returns 0 if some threads could not be created
+static short vec_par_create(size_t threads) {
+    if (threads == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (online > 0) ? (size_t)(online) : 1;
+    }
+
+    threads = min(threads, VEC_PAR_MAX_THREADS);
+
+    vec_par_pool *pool = (vec_par_pool*)(calloc(1, sizeof (vec_par_pool)));
+
+    if (!pool)
+        return 0;
+
+    pool->workers = (pthread_t*)(calloc(threads, sizeof (pthread_t)));
+    pool->ranges = (vec_par_range*)(calloc(threads, sizeof (vec_par_range)));
+
+    if (!pool->workers || !pool->ranges) {
+        free(pool->workers);
+        free(pool->ranges);
+        free(pool);
+        return 0;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < threads; i++)
+        pthread_mutex_init(&pool->ranges[i].lock, NULL);
+
+    pool->threads = 1;
+    vec_par = pool;
+
+    for (size_t i = 1; i < threads; i++) {
+        vec_par_workers[i].pool = pool;
+        vec_par_workers[i].id = i;
+
+        if (pthread_create(&pool->workers[i - 1], NULL, vec_par_main, vec_par_workers + i) != 0) {
+            errno = EAGAIN;
+            return 0;
+        }
+
+        pool->threads++;
+    }
+
+    return 1;
+}
+
+// Runs task on every chunk, vec_par_lock must be held
+static void vec_par_run(size_t chunks, void (*task)(void*, size_t), void *ctx) {
+    if (!vec_par && chunks > 1)
+        vec_par_create(0);
+
+    vec_par_pool *pool = vec_par;
+
+    if (!pool || pool->threads == 1 || chunks == 1) {
+        for (size_t i = 0; i < chunks; i++)
+            task(ctx, i);
+
+        return;
+    }
+
+    // give every thread its share of contiguous chunks
+    for (size_t i = 0; i < pool->threads; i++) {
+        pool->ranges[i].begin = chunks * i / pool->threads;
+        pool->ranges[i].end = chunks * (i + 1) / pool->threads;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->active = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    vec_par_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+short mc_vector_par_init(size_t threads) {
+    pthread_mutex_lock(&vec_par_lock);
+
+    vec_par_destroy();
+    const short res = vec_par_create(threads);
+
+    pthread_mutex_unlock(&vec_par_lock);
+    return res;
+}
+
+void mc_vector_par_shutdown(void) {
+    pthread_mutex_lock(&vec_par_lock);
+    vec_par_destroy();
+    pthread_mutex_unlock(&vec_par_lock);
+}
+
+void mc_vector_par_set_cutoff(size_t length) {
+    pthread_mutex_lock(&vec_par_lock);
+    vec_par_cutoff = length;
+    pthread_mutex_unlock(&vec_par_lock);
+}
+
+
+
+// Chunks. Boundaries are rounded down to a cache line of the buffer, so that no line is written by two threads
+
+typedef struct {
+    long  *data;                            // The first element of the processed range
+    size_t length;                          // The number of elements of the range
+    size_t chunks;                          // The number of chunks of the range
+} vec_par_split;
+
+static vec_par_split vec_par_make_split(long *data, size_t length) {
+    vec_par_split res = { data, length, (length + MC_VECTOR_PAR_CHUNK - 1) / MC_VECTOR_PAR_CHUNK };
+    return res;
+}
+
+static size_t vec_par_bound(const vec_par_split *split, size_t chunk) {
+    if (chunk == 0)
+        return 0;
+
+    if (chunk >= split->chunks)
+        return split->length;
+
+    const uintptr_t address = (uintptr_t)(split->data + chunk * MC_VECTOR_PAR_CHUNK) & ~(uintptr_t)(VEC_PAR_LINE - 1);
+    return (size_t)(address - (uintptr_t)(split->data)) / sizeof (long);
+}
+
+// A vector header borrowing a chunk of another buffer, so that the functions of 'vector.h' can be used on it
+static struct vector_s *vec_par_view(struct vector_s *view, long *data, size_t length) {
+    view->count = length;
+    view->capacity = length;
+    view->data = data;
+    view->heap_buf = NULL;
+    view->map = NULL;
+    view->mapsize = 0;
+    view->allocator = NULL;
+    view->growth = VGrowth_Double;
+    view->align = 0;
+    view->flags = 0;
+    view->bufsize = 0;
+
+#ifdef MC_VECTOR_STATS
+    memset(&view->stats, 0, sizeof (vector_stats));
+#endif
+
+    return view;
+}
+
+// Whether an operation on length elements has to be split between threads (vec_par_lock is held)
+static short vec_par_worth(size_t length) {
+    return length >= vec_par_cutoff && length > MC_VECTOR_PAR_CHUNK;
+}
+
+
+
+typedef struct {
+    vec_par_split split;
+    long value;
+} vec_par_fill_ctx;
+
+static void vec_par_fill_task(void *arg, size_t chunk) {
+    vec_par_fill_ctx *ctx = (vec_par_fill_ctx*)(arg);
+    const size_t begin = vec_par_bound(&ctx->split, chunk), end = vec_par_bound(&ctx->split, chunk + 1);
+    struct vector_s view;
+
+    if (begin < end)
+        mc_vector_fill(vec_par_view(&view, ctx->split.data + begin, end - begin), ctx->value);
+}
+
+short mc_vector_par_fill(vector vec, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    return mc_vector_par_fill_range(vec, 0, vec->count, value);
+}
+
+short mc_vector_par_fill_range(vector vec, size_t index, size_t length, long value) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (index >= vec->count || length == 0 || length > vec->count - index) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    // the workers write through the buffer, which has to be ours (see 'mc_vector_share')
+    if (!mc_vector_unshare(vec))
+        return 0;
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    if (!vec_par_worth(length)) {
+        pthread_mutex_unlock(&vec_par_lock);
+        return mc_vector_fill_range(vec, index, length, value);
+    }
+
+    vec_par_fill_ctx ctx = { vec_par_make_split(vec->data + index, length), value };
+
+    vec_par_run(ctx.split.chunks, vec_par_fill_task, &ctx);
+
+    pthread_mutex_unlock(&vec_par_lock);
+    return 1;
+}
+
+
+
+typedef struct {
+    vec_par_split split;
+    long (*fn)(long, void*);
+    void *ctx;
+} vec_par_transform_ctx;
+
+static void vec_par_transform_task(void *arg, size_t chunk) {
+    vec_par_transform_ctx *ctx = (vec_par_transform_ctx*)(arg);
+    const size_t end = vec_par_bound(&ctx->split, chunk + 1);
+    long *data = ctx->split.data;
+
+    for (size_t i = vec_par_bound(&ctx->split, chunk); i < end; i++)
+        data[i] = ctx->fn(data[i], ctx->ctx);
+}
+
+short mc_vector_par_transform(vector vec, long (*fn)(long, void*), void *ctx) {
+    if (!vec || !fn) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!mc_vector_unshare(vec))
+        return 0;
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    if (!vec_par_worth(vec->count)) {
+        pthread_mutex_unlock(&vec_par_lock);
+        return mc_vector_transform(vec, fn, ctx);
+    }
+
+    vec_par_transform_ctx task = { vec_par_make_split(vec->data, vec->count), fn, ctx };
+
+    vec_par_run(task.split.chunks, vec_par_transform_task, &task);
+
+    pthread_mutex_unlock(&vec_par_lock);
+    return 1;
+}
+
+
+
+// Reductions: every chunk computes its partial result, combined by the calling thread
+
+typedef struct {
+    vec_par_split split;
+    const long *other;                      // The second operand of a dot product
+    long *partial;                          // One result per chunk (two for minmax)
+} vec_par_reduce_ctx;
+
+static void vec_par_sum_task(void *arg, size_t chunk) {
+    vec_par_reduce_ctx *ctx = (vec_par_reduce_ctx*)(arg);
+    const size_t begin = vec_par_bound(&ctx->split, chunk), end = vec_par_bound(&ctx->split, chunk + 1);
+    struct vector_s view;
+
+    ctx->partial[chunk] = 0;
+    mc_vector_sum(vec_par_view(&view, ctx->split.data + begin, end - begin), ctx->partial + chunk);
+}
+
+static void vec_par_minmax_task(void *arg, size_t chunk) {
+    vec_par_reduce_ctx *ctx = (vec_par_reduce_ctx*)(arg);
+    const size_t begin = vec_par_bound(&ctx->split, chunk), end = vec_par_bound(&ctx->split, chunk + 1);
+    struct vector_s view;
+
+    mc_vector_minmax(vec_par_view(&view, ctx->split.data + begin, end - begin),
+                         ctx->partial + 2 * chunk, ctx->partial + 2 * chunk + 1);
+}
+
+static void vec_par_dot_task(void *arg, size_t chunk) {
+    vec_par_reduce_ctx *ctx = (vec_par_reduce_ctx*)(arg);
+    const size_t begin = vec_par_bound(&ctx->split, chunk), end = vec_par_bound(&ctx->split, chunk + 1);
+    struct vector_s view1, view2;
+
+    ctx->partial[chunk] = 0;
+    mc_vector_dot(vec_par_view(&view1, ctx->split.data + begin, end - begin),
+                  vec_par_view(&view2, (long*)(ctx->other) + begin, end - begin), ctx->partial + chunk);
+}
+
+// Runs a reduction over every chunk, returns the partial results (to be freed) or NULL if allocation fails.
+// vec_par_lock must be held
+static long *vec_par_reduce(vec_par_reduce_ctx *ctx, void (*task)(void*, size_t), size_t perChunk) {
+    ctx->partial = (long*)(malloc(ctx->split.chunks * perChunk * sizeof (long)));
+
+    if (ctx->partial)
+        vec_par_run(ctx->split.chunks, task, ctx);
+
+    return ctx->partial;
+}
+
+short mc_vector_par_sum(vector vec, long *out) {
+    if (!vec || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    vec_par_reduce_ctx ctx = { vec_par_make_split(vec->data, vec->count), NULL, NULL };
+
+    if (!vec_par_worth(vec->count) || !vec_par_reduce(&ctx, vec_par_sum_task, 1)) {
+        pthread_mutex_unlock(&vec_par_lock);
+        return mc_vector_sum(vec, out);
+    }
+
+    pthread_mutex_unlock(&vec_par_lock);
+
+    // unsigned arithmetic, so that overflow wraps around like in 'mc_vector_sum'
+    unsigned long res = 0;
+
+    for (size_t i = 0; i < ctx.split.chunks; i++)
+        res += (unsigned long)(ctx.partial[i]);
+
+    free(ctx.partial);
+
+    *out = (long)(res);
+    return 1;
+}
+
+short mc_vector_par_min(vector vec, long *out) {
+    long ignored;
+    return mc_vector_par_minmax(vec, out, &ignored);
+}
+
+short mc_vector_par_max(vector vec, long *out) {
+    long ignored;
+    return mc_vector_par_minmax(vec, &ignored, out);
+}
+
+short mc_vector_par_minmax(vector vec, long *outMin, long *outMax) {
+    if (!vec || !outMin || !outMax) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    vec_par_reduce_ctx ctx = { vec_par_make_split(vec->data, vec->count), NULL, NULL };
+
+    if (!vec_par_worth(vec->count) || !vec_par_reduce(&ctx, vec_par_minmax_task, 2)) {
+        pthread_mutex_unlock(&vec_par_lock);
+        return mc_vector_minmax(vec, outMin, outMax);
+    }
+
+    pthread_mutex_unlock(&vec_par_lock);
+
+    long resMin = ctx.partial[0], resMax = ctx.partial[1];
+
+    for (size_t i = 1; i < ctx.split.chunks; i++) {
+        resMin = (ctx.partial[2 * i] < resMin) ? ctx.partial[2 * i] : resMin;
+        resMax = (ctx.partial[2 * i + 1] > resMax) ? ctx.partial[2 * i + 1] : resMax;
+    }
+
+    free(ctx.partial);
+
+    *outMin = resMin;
+    *outMax = resMax;
+    return 1;
+}
+
+short mc_vector_par_dot(vector vec1, vector vec2, long *out) {
+    if (!vec1 || !vec2 || !out) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (vec1->count != vec2->count) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    vec_par_reduce_ctx ctx = { vec_par_make_split(vec1->data, vec1->count), vec2->data, NULL };
+
+    if (!vec_par_worth(vec1->count) || !vec_par_reduce(&ctx, vec_par_dot_task, 1)) {
+        pthread_mutex_unlock(&vec_par_lock);
+        return mc_vector_dot(vec1, vec2, out);
+    }
+
+    pthread_mutex_unlock(&vec_par_lock);
+
+    unsigned long res = 0;
+
+    for (size_t i = 0; i < ctx.split.chunks; i++)
+        res += (unsigned long)(ctx.partial[i]);
+
+    free(ctx.partial);
+
+    *out = (long)(res);
+    return 1;
+}
+
+
+
+// Parallel LSD radix sort. Keys are the elements with their sign bit flipped, so that unsigned order is signed order.
+// Every pass counts the digits of each chunk, computes where each chunk writes each digit, then scatters the chunks
+
+typedef struct {
+    vec_par_split split;                    // The chunks of the source buffer
+    long   *dst;                            // The destination buffer
+    size_t *counts;                         // VEC_PAR_RADIX counters per chunk (then offsets)
+    unsigned int shift;                     // The position of the digit of the current pass
+} vec_par_sort_ctx;
+
+#define vec_par_digit(x, shift) \
+    ((size_t)((((unsigned long)(x) ^ ((unsigned long)(LONG_MAX) + 1)) >> (shift)) & (VEC_PAR_RADIX - 1)))
+
+static void vec_par_count_task(void *arg, size_t chunk) {
+    vec_par_sort_ctx *ctx = (vec_par_sort_ctx*)(arg);
+    const size_t end = vec_par_bound(&ctx->split, chunk + 1);
+    const long *src = ctx->split.data;
+    size_t *counts = ctx->counts + chunk * VEC_PAR_RADIX;
+
+    memset(counts, 0, VEC_PAR_RADIX * sizeof (size_t));
+
+    for (size_t i = vec_par_bound(&ctx->split, chunk); i < end; i++)
+        counts[vec_par_digit(src[i], ctx->shift)]++;
+}
+
+static void vec_par_scatter_task(void *arg, size_t chunk) {
+    vec_par_sort_ctx *ctx = (vec_par_sort_ctx*)(arg);
+    const size_t end = vec_par_bound(&ctx->split, chunk + 1);
+    const long *src = ctx->split.data;
+    size_t *offsets = ctx->counts + chunk * VEC_PAR_RADIX;
+
+    for (size_t i = vec_par_bound(&ctx->split, chunk); i < end; i++)
+        ctx->dst[offsets[vec_par_digit(src[i], ctx->shift)]++] = src[i];
+}
+
+static void vec_par_copy_task(void *arg, size_t chunk) {
+    vec_par_sort_ctx *ctx = (vec_par_sort_ctx*)(arg);
+    const size_t begin = vec_par_bound(&ctx->split, chunk), end = vec_par_bound(&ctx->split, chunk + 1);
+
+    memcpy(ctx->dst + begin, ctx->split.data + begin, (end - begin) * sizeof (long));
+}
+
+// Turns the counters into offsets, returns 0 if every element has the same digit (the pass can be skipped)
+static short vec_par_offsets(size_t *counts, size_t chunks, size_t length) {
+    size_t offset = 0;
+
+    for (size_t digit = 0; digit < VEC_PAR_RADIX; digit++) {
+        size_t total = 0;
+
+        for (size_t chunk = 0; chunk < chunks; chunk++)
+            total += counts[chunk * VEC_PAR_RADIX + digit];
+
+        if (total == length)
+            return 0;
+
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            const size_t count = counts[chunk * VEC_PAR_RADIX + digit];
+
+            counts[chunk * VEC_PAR_RADIX + digit] = offset;
+            offset += count;
+        }
+    }
+
+    return 1;
+}
+
+short mc_vector_par_sort(vector vec) {
+    if (!vec) {
+        errno = EFAULT;
+        return 0;
+    }
+
+    if (!mc_vector_unshare(vec))
+        return 0;
+
+    pthread_mutex_lock(&vec_par_lock);
+
+    const size_t length = vec->count;
+    long *scratch = NULL;
+    size_t *counts = NULL;
+
+    if (vec_par_worth(length)) {
+        scratch = (long*)(malloc(length * sizeof (long)));
+        counts = (size_t*)(malloc(((length + MC_VECTOR_PAR_CHUNK - 1) / MC_VECTOR_PAR_CHUNK) * VEC_PAR_RADIX
+                                  * sizeof (size_t)));
+    }
+
+    if (!scratch || !counts) {
+        pthread_mutex_unlock(&vec_par_lock);
+
+        free(scratch);
+        free(counts);
+        return mc_vector_sort(vec);
+    }
+
+    vec_par_sort_ctx ctx = { vec_par_make_split(vec->data, length), scratch, counts, 0 };
+
+    for (ctx.shift = 0; ctx.shift < sizeof (long) * CHAR_BIT; ctx.shift += 8) {
+        vec_par_run(ctx.split.chunks, vec_par_count_task, &ctx);
+
+        if (!vec_par_offsets(counts, ctx.split.chunks, length))
+            continue;
+
+        vec_par_run(ctx.split.chunks, vec_par_scatter_task, &ctx);
+
+        // the destination becomes the source of the next pass (chunk boundaries depend on its alignment)
+        long *src = ctx.split.data;
+
+        ctx.split = vec_par_make_split(ctx.dst, length);
+        ctx.dst = src;
+    }
+
+    if (ctx.split.data != vec->data) {
+        ctx.dst = vec->data;
+        vec_par_run(ctx.split.chunks, vec_par_copy_task, &ctx);
+    }
+
+    pthread_mutex_unlock(&vec_par_lock);
+
+    free(scratch);
+    free(counts);
+    return 1;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file   vector_parallel.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Multithreaded versions of the bulk operations of 'vector.h' (fill, transform, reductions and sort), for
+ *         vectors big enough that a single core cannot saturate the memory bandwidth.
+ *
+ *         The buffer of the vector is split into chunks of MC_VECTOR_PAR_CHUNK elements (with boundaries aligned on
+ *         cache lines, so that two threads never write to the same line), processed by a small built-in thread pool.
+ *         Each thread starts with a contiguous range of chunks and steals half of the remaining range of another thread
+ *         once it runs out of work. The calling thread takes part in the work.
+ *         Vectors smaller than the sequential cutoff (see 'mc_vector_par_set_cutoff') are processed by the calling
+ *         thread only, with the functions of 'vector.h'.
+ *
+ *         This is an opt-in compile unit: build 'vector_parallel.c' and link with the pthread library to use it, the
+ *         core library does not depend on it.
+ *
+ *         The pool runs one operation at a time: calls from several threads are serialized, and the functions given
+ *         to 'mc_vector_par_transform' must not call the functions of this file.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_VECTOR_PARALLEL_H
+#define MC_VECTOR_PARALLEL_H
+
+#include <stddef.h>
+
+#include "vector.h"
+
+// The number of elements of a chunk (the unit of work given to a thread)
+#ifndef MC_VECTOR_PAR_CHUNK
+#   define MC_VECTOR_PAR_CHUNK (1 << 15)
+#endif
+
+// The default sequential cutoff: smaller vectors are not split between threads
+#ifndef MC_VECTOR_PAR_CUTOFF
+#   define MC_VECTOR_PAR_CUTOFF (1 << 17)
+#endif
+
+
+#ifndef MC_VECTOR_NO_MACROS
+
+#define vpinit(threads)                     mc_vector_par_init(threads)
+#define vpshutdown()                        mc_vector_par_shutdown()
+#define vpcutoff(length)                    mc_vector_par_set_cutoff(length)
+
+#define vpfill(vec, value)                  mc_vector_par_fill(vec, value)
+#define vpfillr(vec, index, length, value)  mc_vector_par_fill_range(vec, index, length, value)
+#define vptransform(vec, fn, ctx)           mc_vector_par_transform(vec, fn, ctx)
+
+#define vpsum(vec, out)                     mc_vector_par_sum(vec, out)
+#define vpmin(vec, out)                     mc_vector_par_min(vec, out)
+#define vpmax(vec, out)                     mc_vector_par_max(vec, out)
+#define vpminmax(vec, outMin, outMax)       mc_vector_par_minmax(vec, outMin, outMax)
+#define vpdot(v1, v2, out)                  mc_vector_par_dot(v1, v2, out)
+
+#define vpsort(vec)                         mc_vector_par_sort(vec)
+
+#endif /* MC_VECTOR_NO_MACROS */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+
+/**
+ * @brief Starts (or restarts) the thread pool. Calling this function is optional: the pool is started with one thread
+ *        per online processor by the first parallel operation.
+ *
+ * @param[in] threads  The number of threads taking part in an operation, the calling thread included. If 0, the
+ *                     number of online processors is used
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If a thread cannot be created, [errno] will be set to @c EAGAIN. Operations still work, with fewer threads
+ */
+short mc_vector_par_init(size_t threads);
+
+/**
+ * @brief Stops the thread pool, and waits for its threads to exit. The next parallel operation starts it again.
+ */
+void mc_vector_par_shutdown(void);
+
+/**
+ * @brief Sets the sequential cutoff: operations on vectors smaller than 'length' elements are not split between
+ *        threads (MC_VECTOR_PAR_CUTOFF by default).
+ *
+ * @param[in] length  The new cutoff
+ */
+void mc_vector_par_set_cutoff(size_t length);
+
+/**
+ * @brief Parallel version of 'mc_vector_fill'
+ */
+short mc_vector_par_fill(vector vec, long value);
+
+/**
+ * @brief Parallel version of 'mc_vector_fill_range' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_fill_range(vector vec, size_t index, size_t length, long value);
+
+/**
+ * @brief Parallel version of 'mc_vector_transform': replaces every element of the vector by fn(element, ctx).
+ *        Elements are processed by several threads at once, in no particular order, so 'fn' must be safe to call
+ *        concurrently.
+ *
+ * @param[inout] vec  The vector to be transformed
+ * @param[in]    fn   The function applied to every element
+ * @param[in]    ctx  A pointer passed to every call of fn, may be NULL
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector or fn is NULL, [errno] will be set to @c EFAULT
+ */
+short mc_vector_par_transform(vector vec, long (*fn)(long, void*), void *ctx);
+
+/**
+ * @brief Parallel version of 'mc_vector_sum' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_sum(vector vec, long *out);
+
+/**
+ * @brief Parallel version of 'mc_vector_min' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_min(vector vec, long *out);
+
+/**
+ * @brief Parallel version of 'mc_vector_max' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_max(vector vec, long *out);
+
+/**
+ * @brief Parallel version of 'mc_vector_minmax' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_minmax(vector vec, long *outMin, long *outMax);
+
+/**
+ * @brief Parallel version of 'mc_vector_dot' (same arguments, return values and [errno] codes)
+ */
+short mc_vector_par_dot(vector vec1, vector vec2, long *out);
+
+/**
+ * @brief Sorts the vector in ascending order, with a parallel LSD radix sort (each pass builds per-chunk histograms,
+ *        then scatters every chunk to its own offsets). A scratch buffer as big as the vector is allocated.
+ *
+ * @param[inout] vec  The vector to be sorted
+ *
+ * @return 1 if the operation succeeded, 0 otherwise
+ *
+ * @note   If vector is NULL, [errno] will be set to @c EFAULT
+ *         If the scratch buffer cannot be allocated, the vector is sorted by 'mc_vector_sort' instead
+ */
+short mc_vector_par_sort(vector vec);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Header Guard */
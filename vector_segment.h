@@ -0,0 +1,52 @@
+/**
+ * @file   vector_segment.h
+ *
+ * @author Maël Coulmance
+ *
+ * @brief  Internal header: the segment layout shared by the concurrent vector (cvector.c) and the segmented vector
+ *         (svector.c). Segment k holds (base << k) elements, 'base' being a power of two, so that index i lives in
+ *         segment log2(i + base) - log2(base). Not part of the public API.
+ *
+ * @version 1.4
+ *
+ * @date 2022-08-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MC_VECTOR_SEGMENT_H
+#define MC_VECTOR_SEGMENT_H
+
+#include <stddef.h>
+#include <limits.h>
+
+// Enough segments to cover every index
+#define VSEG_MAX_SEGMENTS (sizeof (size_t) * CHAR_BIT)
+
+// The number of elements of segment k
+#define vseg_size(base, k) ((size_t)(base) << (k))
+
+static inline size_t vseg_log2(size_t x) {
+#if defined(__GNUC__)
+    return sizeof (unsigned long long) * CHAR_BIT - 1 - (size_t)(__builtin_clzll((unsigned long long)(x)));
+#else
+    size_t res = 0;
+
+    while (x >>= 1)
+        res++;
+
+    return res;
+#endif
+}
+
+// The segment holding given index, and the position of the index on it
+static inline size_t vseg_locate(size_t index, size_t base, size_t *offset) {
+    const size_t shifted = index + base;
+    const size_t segment = vseg_log2(shifted) - vseg_log2(base);
+
+    *offset = shifted - vseg_size(base, segment);
+    return segment;
+}
+
+#endif /* Header Guard */